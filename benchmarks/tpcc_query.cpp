@@ -199,4 +199,60 @@ QueryStockLevelTPCC::QueryStockLevelTPCC()
     threshold = URand(10, 20);
 }
 
+#if CC_ALG == CALVIN
+///////////////////////////////////////////
+// Lock sets
+///////////////////////////////////////////
+// Some tuples are only known during execution (e.g., a customer selected by last name,
+// or the orders of a district). They are covered by a coarser lock:
+// - custKey(w, d, 0) locks all the customers of district (w, d).
+// - the district locks its ORDER, NEW-ORDER and ORDER-LINE tuples.
+
+void
+QueryPaymentTPCC::get_lock_set(vector<LockRequest> &locks)
+{
+    add_lock(locks, TAB_WAREHOUSE, w_id, TPCCHelper::wh_to_node(w_id), WR);
+    add_lock(locks, TAB_DISTRICT, distKey(w_id, d_id), TPCCHelper::wh_to_node(w_id), WR);
+    add_lock(locks, TAB_CUSTOMER, custKey(c_w_id, c_d_id, 0), TPCCHelper::wh_to_node(c_w_id), WR);
+}
+
+void
+QueryNewOrderTPCC::get_lock_set(vector<LockRequest> &locks)
+{
+    add_lock(locks, TAB_WAREHOUSE, w_id, TPCCHelper::wh_to_node(w_id), RD);
+    add_lock(locks, TAB_DISTRICT, distKey(w_id, d_id), TPCCHelper::wh_to_node(w_id), WR);
+    add_lock(locks, TAB_CUSTOMER, custKey(w_id, d_id, 0), TPCCHelper::wh_to_node(w_id), RD);
+    for (uint32_t i = 0; i < ol_cnt; i ++) {
+        // an invalid item aborts the txn before any item or stock is accessed.
+        if (items[i].ol_i_id == 0)
+            continue;
+#if !REPLICATE_ITEM_TABLE
+        add_lock(locks, TAB_ITEM, items[i].ol_i_id, TPCCHelper::item_to_node(items[i].ol_i_id), RD);
+#endif
+        add_lock(locks, TAB_STOCK, stockKey(items[i].ol_supply_w_id, items[i].ol_i_id),
+                 TPCCHelper::wh_to_node(items[i].ol_supply_w_id), WR);
+    }
+}
+
+void
+QueryOrderStatusTPCC::get_lock_set(vector<LockRequest> &locks)
+{
+    add_lock(locks, TAB_DISTRICT, distKey(w_id, d_id), TPCCHelper::wh_to_node(w_id), RD);
+    add_lock(locks, TAB_CUSTOMER, custKey(w_id, d_id, 0), TPCCHelper::wh_to_node(w_id), RD);
+}
+
+void
+QueryDeliveryTPCC::get_lock_set(vector<LockRequest> &locks)
+{
+    add_lock(locks, TAB_DISTRICT, distKey(w_id, d_id), TPCCHelper::wh_to_node(w_id), WR);
+    add_lock(locks, TAB_CUSTOMER, custKey(w_id, d_id, 0), TPCCHelper::wh_to_node(w_id), WR);
+}
+
+void
+QueryStockLevelTPCC::get_lock_set(vector<LockRequest> &locks)
+{
+    // StockLevel runs without isolation (NO_ACID), so it takes no lock.
+}
+#endif
+
 #endif
@@ -20,6 +20,7 @@ public:
     QueryTPCC();
     QueryTPCC(QueryTPCC * query);
     virtual ~QueryTPCC() {};
+    uint32_t get_txn_type() { return type; }
     uint32_t type;
 
     uint64_t w_id;
@@ -49,6 +50,9 @@ public:
     bool by_last_name;
     char c_last[LASTNAME_LEN];
     double h_amount;
+#if CC_ALG == CALVIN
+    void get_lock_set(vector<LockRequest> &locks);
+#endif
 };
 
 class QueryNewOrderTPCC : public QueryTPCC
@@ -68,6 +72,9 @@ public:
     ~QueryNewOrderTPCC();
 
     uint32_t serialize(char * &raw_data);
+#if CC_ALG == CALVIN
+    void get_lock_set(vector<LockRequest> &locks);
+#endif
 
     Item_no * items;
     bool remote;
@@ -85,6 +92,9 @@ public:
         by_last_name = query->by_last_name;
         memcpy(c_last, query->c_last, LASTNAME_LEN);
     }
+#if CC_ALG == CALVIN
+    void get_lock_set(vector<LockRequest> &locks);
+#endif
 
     bool by_last_name;
     char c_last[LASTNAME_LEN];
@@ -101,6 +111,9 @@ public:
         o_carrier_id = query->o_carrier_id;
         ol_delivery_d = query->ol_delivery_d;
     }
+#if CC_ALG == CALVIN
+    void get_lock_set(vector<LockRequest> &locks);
+#endif
     uint64_t d_id;
     int64_t o_carrier_id;
     int64_t ol_delivery_d;
@@ -115,6 +128,9 @@ public:
     {
         threshold = query->threshold;
     }
+#if CC_ALG == CALVIN
+    void get_lock_set(vector<LockRequest> &locks);
+#endif
 
     int64_t threshold;
 };
@@ -12,6 +12,9 @@
 
 #if WORKLOAD == TPCC
 
+// W_YTD and D_YTD are signed numeric(12,2) in the TPC-C schema.
+#define MAX_YTD 9999999999.99
+
 TPCCStoreProcedure::TPCCStoreProcedure(TxnManager * txn_man, QueryBase * query)
     : StoreProcedure(txn_man, query)
 {
@@ -73,7 +76,7 @@ TPCCStoreProcedure::execute_payment()
         schema = wl->t_warehouse->get_schema();
         index = wl->i_warehouse;
 
-        GET_DATA(key, wl->i_warehouse, WR);
+        GET_DATA(key, wl->i_warehouse, INC_TYPE);
         /*====================================================+
             EXEC SQL UPDATE warehouse SET w_ytd = w_ytd + :h_amount
             WHERE w_id=:w_id;
@@ -84,9 +87,7 @@ TPCCStoreProcedure::execute_payment()
             FROM warehouse
             WHERE w_id=:w_id;
         +===================================================================*/
-        LOAD_VALUE(double, w_ytd, schema, _curr_data, W_YTD);
-        w_ytd += query->h_amount;
-        STORE_VALUE(w_ytd, schema, _curr_data, W_YTD);
+        INC_VALUE(query->h_amount, 0, MAX_YTD, schema, _curr_data, W_YTD);
 
         __attribute__((unused)) LOAD_VALUE(char *, w_name, schema, _curr_data, W_NAME);
         __attribute__((unused)) LOAD_VALUE(char *, w_street_1, schema, _curr_data, W_STREET_1);
@@ -101,14 +102,12 @@ TPCCStoreProcedure::execute_payment()
         // access DISTRICT table
         key = distKey(query->d_w_id, query->d_id);
         schema = wl->t_district->get_schema();
-        GET_DATA(key, wl->i_district, WR);
+        GET_DATA(key, wl->i_district, INC_TYPE);
         /*=====================================================+
             EXEC SQL UPDATE district SET d_ytd = d_ytd + :h_amount
             WHERE d_w_id=:w_id AND d_id=:d_id;
         +=====================================================*/
-        LOAD_VALUE(double, d_ytd, schema, _curr_data, D_YTD);
-        d_ytd += query->h_amount;
-        STORE_VALUE(d_ytd, schema, _curr_data, D_YTD);
+        INC_VALUE(query->h_amount, 0, MAX_YTD, schema, _curr_data, D_YTD);
 
         __attribute__((unused)) LOAD_VALUE(char *, d_name, schema, _curr_data, D_NAME);
         __attribute__((unused)) LOAD_VALUE(char *, d_street_1, schema, _curr_data, D_STREET_1);
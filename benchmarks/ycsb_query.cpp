@@ -174,3 +174,13 @@ QueryYCSB::serialize(char * &raw_data)
     memcpy(raw_data + sizeof(*this), _requests, _request_cnt * sizeof(RequestYCSB));
     return size;
 }
+
+#if CC_ALG == CALVIN
+void
+QueryYCSB::get_lock_set(vector<LockRequest> &locks)
+{
+    for (uint32_t i = 0; i < _request_cnt; i ++)
+        add_lock(locks, 0, _requests[i].key, GET_WORKLOAD->key_to_node(_requests[i].key),
+                 _requests[i].rtype);
+}
+#endif
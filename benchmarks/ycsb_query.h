@@ -28,6 +28,9 @@ public:
     RequestYCSB * get_requests()    { return _requests; }
     void gen_requests();
     bool is_all_remote_readonly() { return _is_all_remote_readonly; }
+#if CC_ALG == CALVIN
+    void get_lock_set(vector<LockRequest> &locks);
+#endif
 
 private:
     uint32_t _request_cnt;
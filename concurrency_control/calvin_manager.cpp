@@ -0,0 +1,301 @@
+#include "calvin_manager.h"
+#include "sequencer.h"
+#include "row_calvin.h"
+#include "manager.h"
+#include "txn.h"
+#include "row.h"
+#include "table.h"
+#include "index_base.h"
+#include "index_hash.h"
+#include "packetize.h"
+#include "query.h"
+#include "store_procedure.h"
+#include "message.h"
+
+#if CC_ALG == CALVIN
+
+CalvinManager::CalvinManager(TxnManager * txn)
+    : CCManager(txn)
+{
+    _last_access = NULL;
+    _submitted = false;
+    _granted = false;
+#if WORKLOAD == TPCC
+    _access_set.reserve(128);
+#endif
+}
+
+RC
+CalvinManager::acquire_locks()
+{
+    if (!_txn->is_sub_txn() && !_submitted) {
+        vector<LockRequest> locks;
+        _txn->get_store_procedure()->get_query()->get_lock_set(locks);
+        for (auto &lock : locks)
+            if (lock.node_id != g_node_id)
+                _lock_nodes.insert(lock.node_id);
+        sequencer->submit(_txn->get_txn_id(), locks);
+        _submitted = true;
+    }
+    return is_txn_ready()? RCOK : WAIT;
+}
+
+bool
+CalvinManager::is_txn_ready()
+{
+    // a granted lock is held until the txn releases it.
+    if (!_granted)
+        _granted = sequencer->is_granted(_txn->get_txn_id());
+    return _granted;
+}
+
+RC
+CalvinManager::get_row(row_t * row, access_t type, uint64_t key)
+{
+    assert(_granted);
+    AccessCalvin * access = NULL;
+    for (vector<AccessCalvin>::iterator it = _access_set.begin(); it != _access_set.end(); it ++) {
+        if (it->row == row) {
+            access = &(*it);
+            break;
+        }
+    }
+    if (!access) {
+        AccessCalvin ac;
+        _access_set.push_back(ac);
+        access = &(*_access_set.rbegin());
+        access->key = key;
+        access->home_node_id = g_node_id;
+        access->table_id = row->get_table()->get_table_id();
+        access->type = RD;
+        access->row = row;
+        access->data_size = row->get_tuple_size();
+    }
+    // keep the original tuple for an abort.
+    if (type == WR && access->type == RD) {
+        access->type = WR;
+        access->data = new char [access->data_size];
+        memcpy(access->data, row->get_data(), access->data_size);
+    }
+    _last_access = access;
+    return RCOK;
+}
+
+RC
+CalvinManager::get_row(row_t * row, access_t type, char * &data, uint64_t key)
+{
+    RC rc = get_row(row, type, key);
+    data = _last_access->row->get_data();
+    return rc;
+}
+
+char *
+CalvinManager::get_data(uint64_t key, uint32_t table_id)
+{
+    // local tuples are written in place.
+    AccessCalvin * access = find_access(key, table_id, &_access_set);
+    if (access)
+        return access->row->get_data();
+    access = find_access(key, table_id, &_remote_set);
+    assert(access);
+    return access->data;
+}
+
+RC
+CalvinManager::register_remote_access(uint32_t remote_node_id, access_t type, uint64_t key, uint32_t table_id)
+{
+    assert(remote_node_id != g_node_id);
+    assert(_lock_nodes.find(remote_node_id) != _lock_nodes.end());
+    AccessCalvin ac;
+    _remote_set.push_back(ac);
+    AccessCalvin * access = &(*_remote_set.rbegin());
+    access->home_node_id = remote_node_id;
+    access->row = NULL;
+    access->type = type;
+    access->key = key;
+    access->table_id = table_id;
+    return LOCAL_MISS;
+}
+
+RC
+CalvinManager::index_read(INDEX * index, uint64_t key, set<row_t *> * &rows, uint32_t limit)
+{
+    uint64_t tt = get_sys_clock();
+    // the latch protects the bucket from the inserts of txns holding other locks.
+    ROW_MAN * manager = index->index_get_manager(key);
+    rows = index->read(key);
+    manager->unlatch();
+    INC_FLOAT_STATS(index, get_sys_clock() - tt);
+    return RCOK;
+}
+
+void
+CalvinManager::cleanup(RC rc)
+{
+    assert(rc == COMMIT || rc == ABORT);
+    for (auto access : _access_set) {
+        if (access.type == WR) {
+            if (rc == ABORT)
+                access.row->copy(access.data);
+            delete [] access.data;
+        }
+    }
+    for (auto access : _remote_set)
+        delete [] access.data;
+    if (rc == ABORT)
+        for (auto ins : _inserts)
+            delete ins.row;
+    _access_set.clear();
+    _remote_set.clear();
+    _inserts.clear();
+    _deletes.clear();
+    sequencer->release(_txn->get_txn_id());
+}
+
+CalvinManager::AccessCalvin *
+CalvinManager::find_access(uint64_t key, uint32_t table_id, vector<AccessCalvin> * set)
+{
+    for (vector<AccessCalvin>::iterator it = set->begin(); it != set->end(); it ++) {
+        if (it->key == key && it->table_id == table_id)
+            return &(*it);
+    }
+    return NULL;
+}
+
+void
+CalvinManager::get_resp_data(uint32_t &size, char * &data)
+{
+    // Format:
+    //    | n | (key, table_id, tuple_size, data) * n
+    UnstructuredBuffer buffer;
+    uint32_t num_tuples = _access_set.size();
+    buffer.put( &num_tuples );
+    for (auto &access : _access_set) {
+        buffer.put( &access.key );
+        buffer.put( &access.table_id );
+        buffer.put( &access.data_size );
+        buffer.put( access.row->get_data(), access.data_size );
+    }
+    size = buffer.size();
+    data = new char [size];
+    memcpy(data, buffer.data(), size);
+}
+
+void
+CalvinManager::process_remote_resp(uint32_t node_id, uint32_t size, char * resp_data)
+{
+    // Format:
+    //    | n | (key, table_id, tuple_size, data) * n
+    UnstructuredBuffer buffer(resp_data);
+    uint32_t num_tuples;
+    buffer.get( &num_tuples );
+    assert(num_tuples > 0);
+    for (uint32_t i = 0; i < num_tuples; i++) {
+        uint64_t key;
+        uint32_t table_id;
+        buffer.get( &key );
+        buffer.get( &table_id );
+        AccessCalvin * access = find_access(key, table_id, &_remote_set);
+        assert(access && node_id == access->home_node_id);
+        buffer.get( &access->data_size );
+        char * data = NULL;
+        buffer.get( data, access->data_size );
+        // a tuple is returned again by the later requests to the same node.
+        if (!access->data)
+            access->data = new char [access->data_size];
+        memcpy(access->data, data, access->data_size);
+    }
+}
+
+void
+CalvinManager::process_commit_phase_coord(RC rc)
+{
+    // no reply is expected. The locks on a node are released once the message arrives.
+    for (auto node_id : _lock_nodes) {
+        uint32_t size = 0;
+        char * data = NULL;
+        if (rc == COMMIT) {
+            // Format
+            //   | num_writes | (key, table_id, size, data) * num_writes
+            UnstructuredBuffer buffer;
+            uint32_t num_writes = 0;
+            for (auto &access : _remote_set)
+                if (access.home_node_id == node_id && access.type == WR)
+                    num_writes ++;
+            if (num_writes > 0) {
+                buffer.put( &num_writes );
+                for (auto &access : _remote_set)
+                    if (access.home_node_id == node_id && access.type == WR) {
+                        buffer.put( &access.key );
+                        buffer.put( &access.table_id );
+                        buffer.put( &access.data_size );
+                        buffer.put( access.data, access.data_size );
+                    }
+                size = buffer.size();
+                data = new char [size];
+                memcpy(data, buffer.data(), size);
+            }
+        }
+        Message::Type type = (rc == COMMIT)? Message::COMMIT_REQ : Message::ABORT_REQ;
+        _txn->send_msg(new Message(type, node_id, _txn->get_txn_id(), size, data));
+    }
+    if (rc == COMMIT)
+        commit_insdel();
+    cleanup(rc);
+}
+
+void
+CalvinManager::process_commit_req(RC rc, uint32_t size, char * data)
+{
+    if (size > 0) {
+        assert(rc == COMMIT);
+        // Format
+        //   | num_writes | (key, table_id, size, data) * num_writes
+        UnstructuredBuffer buffer(data);
+        uint32_t num_writes;
+        buffer.get( &num_writes );
+        for (uint32_t i = 0; i < num_writes; i ++) {
+            uint64_t key;
+            uint32_t table_id;
+            uint32_t tuple_size = 0;
+            char * tuple_data = NULL;
+            buffer.get( &key );
+            buffer.get( &table_id );
+            buffer.get( &tuple_size );
+            buffer.get( tuple_data, tuple_size );
+            AccessCalvin * access = find_access(key, table_id, &_access_set);
+            assert(access && access->type == WR);
+            access->row->copy(tuple_data);
+        }
+    }
+    cleanup(rc);
+}
+
+void
+CalvinManager::abort()
+{
+    cleanup(ABORT);
+}
+
+RC
+CalvinManager::commit_insdel()
+{
+    for (auto ins : _inserts) {
+        row_t * row = ins.row;
+        set<INDEX *> indexes;
+        ins.table->get_indexes( &indexes );
+        for (auto idx : indexes) {
+            uint64_t key = row->get_index_key(idx);
+            idx->insert(key, row);
+        }
+    }
+    for (auto row : _deletes) {
+        set<INDEX *> indexes;
+        row->get_table()->get_indexes( &indexes );
+        for (auto idx : indexes)
+            idx->remove( row );
+    }
+    return RCOK;
+}
+
+#endif
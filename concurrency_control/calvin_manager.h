@@ -0,0 +1,69 @@
+#pragma once
+
+#include "cc_manager.h"
+
+#if CC_ALG == CALVIN
+
+// Deterministic execution (Calvin). Before a txn runs, its home node submits the locks
+// declared by the query to the sequencer. The txn, and each of its sub-txns, runs once
+// the sequencer grants all its locks on that node. Since the lock order is the same on
+// all the nodes, the txn cannot be aborted by CC, and no prepare phase is needed.
+// The home node runs the store procedure and writes in place. At the end, it sends a
+// one-way COMMIT_REQ (with the remote writes) or ABORT_REQ to every other node in the
+// lock set, which applies the writes and releases the locks.
+class CalvinManager : public CCManager
+{
+public:
+    CalvinManager(TxnManager * txn);
+    ~CalvinManager() {};
+
+    // submit the txn to the sequencer the first time. RCOK once all the locks of the
+    // txn on this node are granted; WAIT otherwise.
+    RC             acquire_locks();
+
+    RC             get_row(row_t * row, access_t type, uint64_t key);
+    RC             get_row(row_t * row, access_t type, char * &data, uint64_t key);
+    char *         get_data(uint64_t key, uint32_t table_id);
+    RC             register_remote_access(uint32_t remote_node_id, access_t type, uint64_t key, uint32_t table_id);
+
+    RC             index_read(INDEX * index, uint64_t key, set<row_t *> * &rows, uint32_t limit = -1);
+    // the logical locks also cover the index entries.
+    RC            index_insert(INDEX * index, uint64_t key) { return RCOK; }
+    RC            index_delete(INDEX * index, uint64_t key) { return RCOK; }
+
+    void         cleanup(RC rc);
+
+    void         get_resp_data(uint32_t &size, char * &data);
+    void         process_remote_resp(uint32_t node_id, uint32_t size, char * resp_data);
+
+    bool         is_txn_ready();
+
+    bool         need_prepare_req(uint32_t remote_node_id, uint32_t &size, char * &data) { return false; }
+
+    // commit phase
+    void         process_commit_phase_coord(RC rc);
+    RC            commit_insdel();
+    bool         need_commit_req(RC rc, uint32_t node_id, uint32_t &size, char * &data) { return false; }
+    void         process_commit_req(RC rc, uint32_t size, char * data);
+    void         abort();
+private:
+    struct AccessCalvin : Access {
+        AccessCalvin() { data = NULL; data_size = 0; }
+        // the original tuple of a local write, or the tuple of a remote access.
+        char *        data;
+        uint32_t     data_size;
+    };
+
+    AccessCalvin * find_access(uint64_t key, uint32_t table_id, vector<AccessCalvin> * set);
+
+    vector<AccessCalvin>    _access_set;
+    vector<AccessCalvin>    _remote_set;
+    AccessCalvin *             _last_access;
+
+    bool                     _submitted;
+    bool                     _granted;
+    // the other nodes in the lock set, which are released at the end of the txn.
+    set<uint32_t>             _lock_nodes;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "dl_detect.h"
+#include "helper.h"
+#include "stats.h"
+
+#if CC_ALG == DL_DETECT
+
+DL_detect::DL_detect()
+{
+    pthread_mutex_init(&_latch, NULL);
+    _local_edges = new vector<uint64_t> [g_num_worker_threads];
+    _remote_edges = new vector<uint64_t> [g_num_nodes];
+    _epoch = 0;
+}
+
+void
+DL_detect::set_local_edges(uint32_t thd_id, vector<uint64_t> &edges)
+{
+    pthread_mutex_lock(&_latch);
+    _local_edges[thd_id].swap(edges);
+    pthread_mutex_unlock(&_latch);
+}
+
+void
+DL_detect::set_remote_edges(uint32_t node_id, uint32_t size, char * data)
+{
+    assert(size % sizeof(uint64_t) == 0);
+    uint64_t * edges = (uint64_t *) data;
+    pthread_mutex_lock(&_latch);
+    _remote_edges[node_id].assign(edges, edges + size / sizeof(uint64_t));
+    pthread_mutex_unlock(&_latch);
+}
+
+void
+DL_detect::get_local_edges(uint32_t &size, char * &data)
+{
+    pthread_mutex_lock(&_latch);
+    size = 0;
+    for (uint32_t i = 0; i < g_num_worker_threads; i++)
+        size += _local_edges[i].size() * sizeof(uint64_t);
+    data = (size > 0)? new char [size] : NULL;
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < g_num_worker_threads && size > 0; i++) {
+        memcpy(data + pos, _local_edges[i].data(), _local_edges[i].size() * sizeof(uint64_t));
+        pos += _local_edges[i].size() * sizeof(uint64_t);
+    }
+    pthread_mutex_unlock(&_latch);
+}
+
+void
+DL_detect::add_edges(map<uint64_t, Vertex> &graph, vector<uint64_t> &edges)
+{
+    uint32_t pos = 0;
+    while (pos < edges.size()) {
+        // a txn may wait on several nodes.
+        Vertex &v = graph[ edges[pos] ];
+        v.ts = edges[pos + 1];
+        uint64_t num_holders = edges[pos + 2];
+        v.holders.insert(v.holders.end(), edges.begin() + pos + 3,
+                         edges.begin() + pos + 3 + num_holders);
+        pos += 3 + num_holders;
+    }
+    assert(pos == edges.size());
+}
+
+bool
+DL_detect::find_cycle(map<uint64_t, Vertex> &graph, set<uint64_t> &victims)
+{
+    // 0: not visited, 1: on the DFS path, 2: done.
+    map<uint64_t, uint32_t> state;
+    for (auto &root : graph) {
+        if (state[root.first] != 0 || victims.find(root.first) != victims.end())
+            continue;
+        // each entry is a vertex and the index of its next holder to visit.
+        vector<pair<uint64_t, uint32_t>> path;
+        path.push_back(make_pair(root.first, 0));
+        state[root.first] = 1;
+        while (!path.empty()) {
+            Vertex &v = graph[ path.back().first ];
+            if (path.back().second == v.holders.size()) {
+                state[ path.back().first ] = 2;
+                path.pop_back();
+                continue;
+            }
+            uint64_t holder = v.holders[ path.back().second ++ ];
+            // a holder that does not wait is not in the graph.
+            if (graph.find(holder) == graph.end() || victims.find(holder) != victims.end())
+                continue;
+            if (state[holder] == 1) {
+                // the cycle is the path from holder to the end.
+                uint64_t victim = holder;
+                for (uint32_t i = path.size(); i-- > 0 && path[i].first != holder; ) {
+                    uint64_t txn_id = path[i].first;
+                    if (graph[txn_id].ts > graph[victim].ts
+                        || (graph[txn_id].ts == graph[victim].ts && txn_id > victim))
+                        victim = txn_id;
+                }
+                victims.insert(victim);
+                return true;
+            } else if (state[holder] == 0) {
+                state[holder] = 1;
+                path.push_back(make_pair(holder, 0));
+            }
+        }
+    }
+    return false;
+}
+
+void
+DL_detect::detect()
+{
+    uint64_t t1 = get_sys_clock();
+    map<uint64_t, Vertex> graph;
+    pthread_mutex_lock(&_latch);
+    for (uint32_t i = 0; i < g_num_worker_threads; i++)
+        add_edges(graph, _local_edges[i]);
+    for (uint32_t i = 0; i < g_num_nodes; i++)
+        add_edges(graph, _remote_edges[i]);
+    pthread_mutex_unlock(&_latch);
+
+    // a cycle is broken once its victim is removed, so cycles are searched one at a time.
+    set<uint64_t> victims;
+    while (find_cycle(graph, victims)) {}
+
+    // a deadlock is found again until its victim aborts. Only count it once.
+    uint32_t num_deadlocks = 0;
+    pthread_mutex_lock(&_latch);
+    for (auto victim : victims)
+        if (_victims.find(victim) == _victims.end())
+            num_deadlocks ++;
+    _victims.swap(victims);
+    pthread_mutex_unlock(&_latch);
+    _epoch ++;
+
+    stats->cycle_detect ++;
+    stats->deadlock += num_deadlocks;
+    stats->dl_detect_time += get_sys_clock() - t1;
+}
+
+bool
+DL_detect::is_victim(uint64_t txn_id)
+{
+    pthread_mutex_lock(&_latch);
+    bool victim = (_victims.find(txn_id) != _victims.end());
+    pthread_mutex_unlock(&_latch);
+    return victim;
+}
+
+#endif
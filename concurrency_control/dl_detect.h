@@ -0,0 +1,47 @@
+#pragma once
+
+#include "global.h"
+
+#if CC_ALG == DL_DETECT
+
+// Distributed deadlock detection.
+// The waits-for graph has one vertex per txn_id, so a txn and its sub-txns are the
+// same vertex. Each node collects the edges of its lock waiters and sends them to
+// the other nodes every DL_DETECT_INTERVAL. Every node searches cycles in the union of
+// the edges and picks the youngest txn of each cycle as the victim. The node where
+// the victim waits aborts it. Since all nodes pick the same victim for a cycle,
+// no extra message is needed.
+//
+// Edge format (a list of uint64_t, also used in DL_EDGES):
+//   | txn_id | timestamp | n | txn_id of holder 1 | ... | txn_id of holder n |
+class DL_detect {
+public:
+    DL_detect();
+    // the edges of the lock waiters of a worker thread.
+    void         set_local_edges(uint32_t thd_id, vector<uint64_t> &edges);
+    void         set_remote_edges(uint32_t node_id, uint32_t size, char * data);
+    // all the local edges, to be sent to the other nodes.
+    void         get_local_edges(uint32_t &size, char * &data);
+
+    // search for cycles and choose the victims. Called by a single thread.
+    void         detect();
+    bool         is_victim(uint64_t txn_id);
+    // incremented after each detect().
+    uint64_t     get_epoch() { return _epoch; }
+private:
+    struct Vertex {
+        uint64_t ts;
+        vector<uint64_t> holders;
+    };
+    void         add_edges(map<uint64_t, Vertex> &graph, vector<uint64_t> &edges);
+    // find one cycle not going through the victims, and add its youngest txn to them.
+    bool         find_cycle(map<uint64_t, Vertex> &graph, set<uint64_t> &victims);
+
+    pthread_mutex_t          _latch;
+    vector<uint64_t> *       _local_edges;
+    vector<uint64_t> *       _remote_edges;
+    set<uint64_t>            _victims;
+    volatile uint64_t        _epoch;
+};
+
+#endif
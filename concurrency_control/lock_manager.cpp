@@ -10,17 +10,25 @@
 #include "query.h"
 #include "workload.h"
 #include "store_procedure.h"
+#include "message.h"
+#include "server_thread.h"
 
-#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT
+#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
 
 LockManager::LockManager(TxnManager * txn)
     : CCManager(txn)
 {
     _num_lock_waits = 0;
-#if CC_ALG == WAIT_DIE
-    assert(g_ts_alloc == TS_CLOCK);
+#if CC_ALG == WAIT_DIE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    assert(g_ts_alloc == TS_CLOCK || g_ts_alloc == TS_HLC);
     _timestamp = glob_manager->get_ts(GET_THD_ID);
 #endif
+#if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    _wounded = false;
+#endif
+#if CC_ALG == WOUND_WAIT
+    _wound_forwarded = false;
+#endif
 #if WORKLOAD == TPCC
     _access_set.reserve(128);
 #endif
@@ -31,6 +39,16 @@ LockManager::get_row(row_t * row, access_t type, uint64_t key)
 {
     RC rc = RCOK;
     _num_lock_waits = 0;
+#if CC_ALG == DL_DETECT
+    _wait_locks.clear();
+#endif
+#if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    if (_wounded) {
+        if (!_txn->is_sub_txn())
+            INC_INT_STATS(num_aborts_wound, 1);
+        return ABORT;
+    }
+#endif
     Isolation isolation = SR;
     if (!_txn->is_sub_txn())
         isolation = _txn->get_store_procedure()->get_query()->get_isolation_level();
@@ -43,7 +61,8 @@ LockManager::get_row(row_t * row, access_t type, uint64_t key)
         }
     }
     if (!access) {
-        Row_lock::LockType lock_type = (type == RD)? Row_lock::LOCK_SH : Row_lock::LOCK_EX;
+        Row_lock::LockType lock_type = (type == RD)? Row_lock::LOCK_SH :
+            (type == INC)? Row_lock::LOCK_INC : Row_lock::LOCK_EX;
         if (isolation != NO_ACID)
             rc = row->manager->lock_get(lock_type, _txn);
         if (rc == ABORT) return rc;
@@ -60,10 +79,15 @@ LockManager::get_row(row_t * row, access_t type, uint64_t key)
         access->data_size = row->get_tuple_size();
         if (rc == WAIT) {
             ATOM_ADD_FETCH(_num_lock_waits, 1);
+#if CC_ALG == DL_DETECT
+            _wait_locks.push_back(row->manager);
+#endif
         }
         if (rc != RCOK)
             return rc;
     }
+    // INC accesses are not mixed with reads and writes, and not undone on abort.
+    assert((type == INC) == (access->type == INC));
     if (type == WR) {
         assert(access->data == NULL);
         access->data = new char [access->row->get_tuple_size()];
@@ -117,6 +141,13 @@ RC
 LockManager::index_get_permission(access_t type, INDEX * index, uint64_t key, uint32_t limit)
 {
     RC rc = RCOK;
+#if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    if (_wounded) {
+        if (!_txn->is_sub_txn())
+            INC_INT_STATS(num_aborts_wound, 1);
+        return ABORT;
+    }
+#endif
     for (uint32_t i = 0; i < _index_access_set.size(); i++) {
         IndexAccess * ac = &_index_access_set[i];
         if (ac->index == index && ac->key == key)  {
@@ -127,8 +158,12 @@ LockManager::index_get_permission(access_t type, INDEX * index, uint64_t key, ui
                 if (type != RD) {
                     ac->type = type;
                     rc = ac->manager->lock_get(Row_lock::LOCK_EX, _txn);
-                    if (rc == WAIT)
+                    if (rc == WAIT) {
                         ATOM_ADD_FETCH(_num_lock_waits, 1);
+#if CC_ALG == DL_DETECT
+                        _wait_locks.push_back(ac->manager);
+#endif
+                    }
                     return rc;
                 }
             }
@@ -155,6 +190,9 @@ LockManager::index_get_permission(access_t type, INDEX * index, uint64_t key, ui
 
     if (rc == WAIT) {
         ATOM_ADD_FETCH(_num_lock_waits, 1);
+#if CC_ALG == DL_DETECT
+        _wait_locks.push_back(manager);
+#endif
     }
     return rc;
 }
@@ -194,7 +232,7 @@ LockManager::index_delete(INDEX * index, uint64_t key)
 void
 LockManager::add_remote_req_header(UnstructuredBuffer * buffer)
 {
-#if CC_ALG == WAIT_DIE
+#if CC_ALG == WAIT_DIE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
     buffer->put_front( &_timestamp );
 #endif
 }
@@ -202,7 +240,7 @@ LockManager::add_remote_req_header(UnstructuredBuffer * buffer)
 uint32_t
 LockManager::process_remote_req_header(UnstructuredBuffer * buffer)
 {
-#if CC_ALG == WAIT_DIE
+#if CC_ALG == WAIT_DIE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
     buffer->get( &_timestamp );
     return sizeof(_timestamp);
 #else
@@ -217,16 +255,19 @@ LockManager::cleanup(RC rc)
     Isolation isolation = SR;
     if (!_txn->is_sub_txn())
         isolation = _txn->get_store_procedure()->get_query()->get_isolation_level();
+    // the increments are applied while the INC locks are held.
+    apply_increments(rc);
     for (uint32_t i = 0; i < _access_set.size(); i ++) {
         AccessLock * access = &_access_set[i];
         access_t type = access->type;
-        if (type == WR && rc == ABORT)
+        // data is NULL if a wounded txn aborts while waiting for the lock.
+        if (type == WR && rc == ABORT && access->data)
             access->row->copy(access->data);
         if (isolation != NO_ACID)
             access->row->manager->lock_release(_txn, rc);
 
         if (type == WR) {
-            assert(access->data);
+            assert(access->data || ((CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT) && rc == ABORT));
             delete access->data;
         } else
             assert(access->data == NULL);
@@ -244,6 +285,9 @@ LockManager::cleanup(RC rc)
         for (auto ins : _inserts)
             delete ins.row;
     _num_lock_waits = 0;
+#if CC_ALG == DL_DETECT
+    _wait_locks.clear();
+#endif
     _access_set.clear();
     _remote_set.clear();
     _inserts.clear();
@@ -254,7 +298,12 @@ LockManager::cleanup(RC rc)
 bool
 LockManager::is_txn_ready()
 {
+#if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    // a wounded txn wakes up to abort itself.
+    return _num_lock_waits == 0 || _wounded;
+#else
     return _num_lock_waits == 0;
+#endif
 }
 
 void
@@ -264,6 +313,84 @@ LockManager::set_txn_ready(RC rc)
     ATOM_SUB_FETCH(_num_lock_waits, 1);
 }
 
+#if CC_ALG == WOUND_WAIT
+void
+LockManager::wound(TxnManager * holder)
+{
+    // called with the row latched, so the holder cannot finish meanwhile.
+    LockManager * manager = (LockManager *) holder->get_cc_manager();
+    if (manager->_wounded || !ATOM_CAS(manager->_wounded, false, true))
+        return;
+    // the holder does not finish while the row is latched.
+    holder->get_server_thread()->wakeup(holder->get_txn_id());
+    if (holder->is_sub_txn()) {
+        // the locks of a sub-txn are released by the 2PC of its coordinator.
+        uint32_t home_node = glob_manager->txnid_to_server_node(holder->get_txn_id());
+        char * data = new char [sizeof(uint64_t)];
+        memcpy(data, &manager->_timestamp, sizeof(uint64_t));
+        _txn->send_msg(new Message(Message::WOUND_REQ, home_node, holder->get_txn_id(),
+                                   sizeof(uint64_t), data));
+    }
+}
+
+void
+LockManager::process_wound_req(uint32_t size, char * data)
+{
+    // Format
+    //   | timestamp |
+    // the txn may have restarted with a new timestamp, or already be committing.
+    assert(size == sizeof(uint64_t));
+    uint64_t ts = *(uint64_t *)data;
+    if (ts == _timestamp && _txn->get_txn_state() == TxnManager::RUNNING) {
+        _wounded = true;
+        _txn->get_server_thread()->wakeup(_txn->get_txn_id());
+    }
+}
+
+void
+LockManager::forward_wound()
+{
+    if (!_wounded || _wound_forwarded || _txn->get_txn_state() != TxnManager::RUNNING)
+        return;
+    // a wounded txn sends no new remote requests, so forwarding once is enough.
+    _wound_forwarded = true;
+    for (uint32_t node : _txn->remote_nodes_involved) {
+        char * data = new char [sizeof(uint64_t)];
+        memcpy(data, &_timestamp, sizeof(uint64_t));
+        _txn->send_msg(new Message(Message::WOUND_REQ, node, _txn->get_txn_id(),
+                                   sizeof(uint64_t), data));
+    }
+}
+
+RC
+LockManager::process_prepare_phase_coord()
+{
+    // the last chance for a wounded txn to abort.
+    if (_wounded) {
+        INC_INT_STATS(num_aborts_wound, 1);
+        return ABORT;
+    }
+    return RCOK;
+}
+#endif
+
+#if CC_ALG == DL_DETECT
+void
+LockManager::get_wait_edges(vector<uint64_t> &edges)
+{
+    uint32_t start = edges.size();
+    edges.push_back(_txn->get_txn_id());
+    edges.push_back(_timestamp);
+    edges.push_back(0);
+    for (uint32_t i = 0; i < _wait_locks.size(); i++)
+        _wait_locks[i]->get_waits_for(_txn, edges);
+    edges[start + 2] = edges.size() - start - 3;
+    // not waiting any more.
+    if (edges[start + 2] == 0)
+        edges.resize(start);
+}
+#endif
+
 void
 LockManager::get_resp_data(uint32_t &size, char * &data)
 {
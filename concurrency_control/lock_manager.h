@@ -30,6 +30,24 @@ public:
     uint64_t     get_priority() { return _timestamp; }
     bool         is_txn_ready();
     void         set_txn_ready(RC rc);
+#if CC_ALG == WOUND_WAIT
+    // wound a younger lock holder. A wounded txn aborts at its next lock request or
+    // before the prepare phase. For a sub-txn, its coordinator is told with WOUND_REQ.
+    void         wound(TxnManager * holder);
+    void         process_wound_req(uint32_t size, char * data);
+    bool         is_wounded() { return _wounded; }
+    // pass the wound of a coordinator to its sub-txns, which may be waiting for locks.
+    // Called by the thread owning the txn.
+    void         forward_wound();
+
+    RC             process_prepare_phase_coord();
+#endif
+#if CC_ALG == DL_DETECT
+    // a deadlock victim is wounded by the thread owning it, and aborts when it wakes up.
+    void         wound_victim() { _wounded = true; }
+    // the edges of this txn in the waits-for graph, in the format of DL_detect.
+    void         get_wait_edges(vector<uint64_t> &edges);
+#endif
 
     // Prepare Phase
     RC             process_prepare_req(uint32_t size, char * data, uint32_t &resp_size, char * &resp_data);
@@ -55,4 +73,14 @@ private:
     AccessLock *             _last_access;
 
     bool                     _lock_ready;
+#if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    volatile bool             _wounded;
+#endif
+#if CC_ALG == WOUND_WAIT
+    bool                     _wound_forwarded;
+#endif
+#if CC_ALG == DL_DETECT
+    // the locks this txn has waited for since its last lock request.
+    vector<Row_lock *>         _wait_locks;
+#endif
 };
@@ -0,0 +1,28 @@
+#include "row_calvin.h"
+#include "row.h"
+
+#if CC_ALG == CALVIN
+
+Row_calvin::Row_calvin(row_t * row)
+{
+    _latch = NULL;
+    if (!row) {
+        _latch = new pthread_mutex_t;
+        pthread_mutex_init( _latch, NULL );
+    }
+}
+
+void
+Row_calvin::latch()
+{
+    assert(_latch);
+    pthread_mutex_lock( _latch );
+}
+
+void
+Row_calvin::unlatch()
+{
+    pthread_mutex_unlock( _latch );
+}
+
+#endif
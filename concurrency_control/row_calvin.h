@@ -0,0 +1,22 @@
+#pragma once
+
+#include "global.h"
+
+#if CC_ALG == CALVIN
+
+class row_t;
+
+// CALVIN locks logical keys in the sequencer, so a tuple has no CC state.
+// Only index buckets use the latch, to protect the bucket structure.
+class Row_calvin {
+public:
+    Row_calvin() : Row_calvin(NULL) {};
+    Row_calvin(row_t * row);
+
+    void             latch();
+    void             unlatch();
+private:
+    pthread_mutex_t *        _latch;
+};
+
+#endif
@@ -5,21 +5,13 @@
 #include "lock_manager.h"
 #include "f1_manager.h"
 
-#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == F_ONE
+#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT \
+    || CC_ALG == DL_DETECT
 
-#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE
-bool
-Row_lock::CompareWait::operator() (const WaitEntry &en1, const WaitEntry &en2) const
-{
-    return LOCK_MAN(en1.txn)->get_ts() < LOCK_MAN(en2.txn)->get_ts();
-}
-
-bool
-Row_lock::CompareLock::operator() (TxnManager * txn1, TxnManager * txn2) const
-{
-    return LOCK_MAN(txn1)->get_ts() < LOCK_MAN(txn2)->get_ts();
-}
-#endif
+// TxnManager is at least 8-byte aligned, so the low bits of _lock_word are free.
+#define LOCK_WORD_EX     1UL
+#define LOCK_INFLATED     2UL
+#define LOCK_WORD_TXN(w) ((TxnManager *)((w) & ~LOCK_WORD_EX))
 
 Row_lock::Row_lock()
 {
@@ -28,6 +20,7 @@ Row_lock::Row_lock()
     _lock_type = LOCK_NONE;
       _max_num_waits = g_max_num_waits;
     _upgrading_txn = NULL;
+    init_lock_table();
 }
 
 Row_lock::Row_lock(row_t * row)
@@ -36,6 +29,30 @@ Row_lock::Row_lock(row_t * row)
     _row = row;
 }
 
+Row_lock::~Row_lock()
+{
+    if (_owners != _owner_buf)
+        delete [] _owners;
+#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    if (_waiters != _wait_buf)
+        delete [] _waiters;
+#endif
+}
+
+void
+Row_lock::init_lock_table()
+{
+    _lock_word = 0;
+    _owners = _owner_buf;
+    _num_owners = 0;
+    _max_owners = LOCK_INLINE_OWNERS;
+#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    _waiters = _wait_buf;
+    _num_waiters = 0;
+    _max_waiters = LOCK_INLINE_WAITERS;
+#endif
+}
+
 void
 Row_lock::latch()
 {
@@ -55,15 +72,22 @@ Row_lock::init(row_t * row)
     pthread_mutex_init(&_latch, NULL);
     _lock_type = LOCK_NONE;
       _max_num_waits = g_max_num_waits;
+    init_lock_table();
 }
 
 RC
 Row_lock::lock_get(LockType type, TxnManager * txn, bool need_latch)
 {
     RC rc = RCOK;
+    uint64_t new_word = (uint64_t)txn | ((type == LOCK_EX)? LOCK_WORD_EX : 0);
+    assert(((uint64_t)txn & (LOCK_WORD_EX | LOCK_INFLATED)) == 0);
+    // fast path: the row is not locked.
+    uint64_t word = _lock_word;
+    if (word == 0 && type != LOCK_INC && ATOM_CAS(_lock_word, 0, new_word))
+        return RCOK;
 #if CC_ALG == NO_WAIT
-    if (conflict_lock(_lock_type, type)) {
-        if (type == _lock_type) {
+    if (conflict_lock(get_lock_type(), type)) {
+        if (type == get_lock_type()) {
             INC_INT_STATS(num_aborts_ws, 1);
         } else {
             INC_INT_STATS(num_aborts_rs, 1);
@@ -73,24 +97,53 @@ Row_lock::lock_get(LockType type, TxnManager * txn, bool need_latch)
 #endif
     if (need_latch)
         pthread_mutex_lock( &_latch );
-    if (_locking_set.find(txn) != _locking_set.end()) {
+    word = _lock_word;
+    if (word != LOCK_INFLATED && LOCK_WORD_TXN(word) == txn) {
+        assert(type != LOCK_INC);
+        // the only holder. Upgrade in place, or just ignore.
+        if (type == LOCK_EX && !(word & LOCK_WORD_EX)) {
+            _upgrading_txn = txn;
+            bool success = ATOM_CAS(_lock_word, word, new_word);
+            assert(success);
+        }
+        if (need_latch)
+            pthread_mutex_unlock( &_latch );
+        return RCOK;
+    }
+    inflate();
+    if (find_owner(txn)) {
+        // a txn does not mix INC with reads or writes of a tuple.
+        assert((type == LOCK_INC) == (_lock_type == LOCK_INC));
         // upgrade request.
         if (_lock_type != type) {
             if (_lock_type == LOCK_SH) {
                 assert(type == LOCK_EX);
                 _upgrading_txn = txn;
-                if (_locking_set.size() == 1) {
+                if (_num_owners == 1) {
                     _lock_type = LOCK_EX;
                     rc = RCOK;
                 } else {
                     _lock_type = LOCK_UPGRADING;
                     rc = WAIT;
+#if CC_ALG == WOUND_WAIT
+                    wound_owners(txn);
+#endif
                 }
             } else {
                 assert(_lock_type == LOCK_UPGRADING);
+#if CC_ALG == WOUND_WAIT
+                // an older txn takes over the upgrade. The current upgrader is
+                // younger, so it is wounded with the other younger holders.
+                if (LOCK_MAN(txn)->get_ts() < LOCK_MAN(_upgrading_txn)->get_ts()) {
+                    _upgrading_txn = txn;
+                    wound_owners(txn);
+                    rc = WAIT;
+                } else
+#endif
                 rc = ABORT;
             }
         } // else just ignore.
+        deflate();
         if (need_latch)
             pthread_mutex_unlock( &_latch );
         return rc;
@@ -106,19 +159,39 @@ Row_lock::lock_get(LockType type, TxnManager * txn, bool need_latch)
         }
         rc = ABORT;
     }
-#elif CC_ALG == WAIT_DIE || CC_ALG == F_ONE
+#elif CC_ALG == WAIT_DIE || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+  #if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    // an older waiter is served first.
+    if (!conflict)
+        if (_num_waiters > 0 && LOCK_MAN(_waiters[0].txn)->get_ts() < LOCK_MAN(txn)->get_ts())
+            conflict = true;
+    if (conflict) {
+        assert(_num_owners > 0);
+        if (_num_waiters > _max_num_waits) {
+            rc = ABORT;
+            INC_INT_STATS(int_debug1, 1);
+        } else {
+    #if CC_ALG == WOUND_WAIT
+            // wait for the younger holders to abort.
+            wound_owners(txn);
+    #endif
+            rc = WAIT;
+            INC_INT_STATS(int_debug3, 1);
+        }
+    }
+  #else
     // check conflict between incoming txn and waiting txns.
     if (!conflict)
-        if (!_waiting_set.empty() && LOCK_MAN(_waiting_set.rbegin()->txn)->get_ts() > LOCK_MAN(txn)->get_ts())
+        if (_num_waiters > 0 && LOCK_MAN(_waiters[_num_waiters - 1].txn)->get_ts() > LOCK_MAN(txn)->get_ts())
             conflict = true;
     if (conflict) {
-        assert(!_locking_set.empty());
-        if (_waiting_set.size() > _max_num_waits) {
+        assert(_num_owners > 0);
+        if (_num_waiters > _max_num_waits) {
             rc = ABORT;
             INC_INT_STATS(int_debug1, 1);
         }
-        else if (LOCK_MAN(txn)->get_ts() > LOCK_MAN(*_locking_set.begin())->get_ts() ||
-            (!_waiting_set.empty() && LOCK_MAN(txn)->get_ts() > LOCK_MAN(_waiting_set.begin()->txn)->get_ts())) {
+        else if (LOCK_MAN(txn)->get_ts() > LOCK_MAN(oldest_owner())->get_ts() ||
+            (_num_waiters > 0 && LOCK_MAN(txn)->get_ts() > LOCK_MAN(_waiters[0].txn)->get_ts())) {
             rc = ABORT;
             INC_INT_STATS(int_debug2, 1);
         } else {
@@ -126,12 +199,12 @@ Row_lock::lock_get(LockType type, TxnManager * txn, bool need_latch)
             INC_INT_STATS(int_debug3, 1);
         }
     }
+  #endif
     if (rc == WAIT) {
-        WaitEntry entry = {type, txn};
-        assert(!_locking_set.empty());
-        for (auto entry : _waiting_set)
-            assert(entry.txn != txn);
-        _waiting_set.insert(entry);
+        assert(_num_owners > 0);
+        for (uint32_t i = 0; i < _num_waiters; i ++)
+            assert(_waiters[i].txn != txn);
+        add_waiter(type, txn);
         txn->_start_wait_time = get_sys_clock();
     }
     // ABORT Stats
@@ -145,10 +218,9 @@ Row_lock::lock_get(LockType type, TxnManager * txn, bool need_latch)
 #endif
     if (rc == RCOK) {
         _lock_type = type;
-        uint32_t size = _locking_set.size();
-        _locking_set.insert(txn);
-        M_ASSERT(_locking_set.size() == size + 1, "locking_set.size=%ld, size=%d\n", _locking_set.size(), size);
+        add_owner(txn);
     }
+    deflate();
 
     if (need_latch)
         pthread_mutex_unlock( &_latch );
@@ -159,94 +231,179 @@ Row_lock::lock_get(LockType type, TxnManager * txn, bool need_latch)
 RC
 Row_lock::lock_release(TxnManager * txn, RC rc)
 {
-    pthread_mutex_lock( &_latch );
+    // fast path: txn is the only holder.
+    uint64_t word = _lock_word;
+    if (word != LOCK_INFLATED && LOCK_WORD_TXN(word) == txn && ATOM_CAS(_lock_word, word, 0))
+        return RCOK;
 
-    uint32_t released = _locking_set.erase(txn);
+    pthread_mutex_lock( &_latch );
+    inflate();
+    bool released = remove_owner(txn);
 #if CC_ALG == F_ONE
-    if (released != 1) {
-        // remove the txn from the _waiting_set
-        for (std::set<WaitEntry>::iterator it = _waiting_set.begin();
-            it != _waiting_set.end(); it ++)
-        {
-            if (it->txn == txn) {
-                _waiting_set.erase(it);
+    if (!released) {
+        // remove the txn from the waiters
+        for (uint32_t i = 0; i < _num_waiters; i ++) {
+            if (_waiters[i].txn == txn) {
+                remove_waiter(i);
                 break;
             }
         }
+        deflate();
         pthread_mutex_unlock( &_latch );
         return RCOK;
     }
+#elif CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    if (!released) {
+        // a wounded txn aborts while waiting. The waiters behind it may be granted.
+        for (uint32_t i = 0; i < _num_waiters; i ++) {
+            if (_waiters[i].txn == txn) {
+                remove_waiter(i);
+                released = true;
+                break;
+            }
+        }
+    }
 #endif
-    if (released == 0) {
+    if (!released) {
+        deflate();
         pthread_mutex_unlock( &_latch );
         return RCOK;
     }
 
-#if CC_ALG == F_ONE || CC_ALG == WAIT_DIE
+#if CC_ALG == F_ONE || CC_ALG == WAIT_DIE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
     assert(LOCK_MAN(txn)->get_ts() > 0);
-    bool done = (released == 1)? false : true;
+    bool done = false;
   #if CC_ALG == F_ONE
     if (!done && rc == COMMIT && _lock_type == LOCK_EX) {
-        for ( set<WaitEntry>::iterator it = _waiting_set.begin();
-                it != _waiting_set.end(); it ++)
-        {
-            it->txn->set_txn_ready(ABORT);
+        for (uint32_t i = 0; i < _num_waiters; i ++) {
+            _waiters[i].txn->set_txn_ready(ABORT);
             // ABORT Stats
-            if (it->type == LOCK_EX) {
+            if (_waiters[i].type == LOCK_EX) {
                 INC_INT_STATS(num_aborts_ws, 1);
             } else {
                 INC_INT_STATS(num_aborts_rs, 1);
             }
         }
-        _waiting_set.clear();
+        _num_waiters = 0;
         done = true;
     }
   #endif
     // handle upgrade
-    if (_lock_type == LOCK_UPGRADING) {
-        assert(_locking_set.size() >= 1);
-        if (_locking_set.size() == 1) {
-            TxnManager * t = *_locking_set.begin();
+    if (_lock_type == LOCK_UPGRADING && txn == _upgrading_txn) {
+        // the upgrader was wounded or chosen as a deadlock victim while waiting.
+        // The other holders keep the lock shared.
+        _upgrading_txn = NULL;
+        _lock_type = LOCK_SH;
+    } else if (_lock_type == LOCK_UPGRADING) {
+        assert(_num_owners >= 1);
+        if (_num_owners == 1) {
+            TxnManager * t = _owners[0];
             assert(t == _upgrading_txn);
             _lock_type = LOCK_EX;
             t->set_txn_ready(RCOK);
         }
+        deflate();
         pthread_mutex_unlock( &_latch );
         return RCOK;
     }
-    if (_locking_set.empty())
+    if (_num_owners == 0)
         _lock_type = LOCK_NONE;
+    // grant the lock to the youngest waiters first.
+    // For WOUND_WAIT and DL_DETECT, the oldest waiters go first.
     while (!done) {
-        std::set<WaitEntry>::reverse_iterator rit = _waiting_set.rbegin();
-        if (rit != _waiting_set.rend() && !conflict_lock(rit->type, _lock_type))
+#if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+        uint32_t idx = 0;
+#else
+        uint32_t idx = _num_waiters - 1;
+#endif
+        if (_num_waiters > 0 && !conflict_lock(_waiters[idx].type, _lock_type))
         {
-            _lock_type = rit->type;
-            _locking_set.insert(rit->txn);
+            WaitEntry entry = _waiters[idx];
+            _lock_type = entry.type;
+            add_owner(entry.txn);
 
             // for F_ONE, if the current txn commits a write, all waiting txns should abort.
-            rit->txn->set_txn_ready(RCOK);
-            _waiting_set.erase( --rit.base() );
+            entry.txn->set_txn_ready(RCOK);
+            remove_waiter(idx);
         } else
             done = true;
     }
-    if (_locking_set.empty())
-        assert(_waiting_set.empty());
+    if (_num_owners == 0)
+        assert(_num_waiters == 0);
 #elif CC_ALG == NO_WAIT
-    if (_locking_set.empty())
+    if (_num_owners == 0)
         _lock_type = LOCK_NONE;
 #else
     assert(false);
 #endif
+    deflate();
     pthread_mutex_unlock( &_latch );
     return RCOK;
 }
 
+#if INC_SUPPORTED
+RC
+Row_lock::escrow_reserve(char * field, double delta, double min, double max)
+{
+    RC rc = RCOK;
+    pthread_mutex_lock( &_latch );
+    Escrow * escrow = NULL;
+    for (auto &e : _escrows)
+        if (e.field == field)
+            escrow = &e;
+    if (!escrow) {
+        _escrows.push_back(Escrow {field, 0, 0, 0});
+        escrow = &_escrows.back();
+    }
+    double value = *(double *) field;
+    if (value + escrow->low + std::min(delta, 0.0) < min
+        || value + escrow->high + std::max(delta, 0.0) > max)
+        rc = ABORT;
+    else {
+        if (delta < 0)
+            escrow->low += delta;
+        else
+            escrow->high += delta;
+        escrow->num_deltas ++;
+    }
+    if (escrow->num_deltas == 0)
+        _escrows.pop_back();
+    pthread_mutex_unlock( &_latch );
+    return rc;
+}
+
+void
+Row_lock::escrow_release(char * field, double delta, bool apply)
+{
+    pthread_mutex_lock( &_latch );
+    for (uint32_t i = 0; i < _escrows.size(); i ++) {
+        Escrow &e = _escrows[i];
+        if (e.field != field)
+            continue;
+        if (delta < 0)
+            e.low -= delta;
+        else
+            e.high -= delta;
+        if (apply)
+            *(double *) field += delta;
+        if (-- e.num_deltas == 0) {
+            e = _escrows.back();
+            _escrows.pop_back();
+        }
+        break;
+    }
+    pthread_mutex_unlock( &_latch );
+}
+#endif
+
 bool Row_lock::conflict_lock(LockType l1, LockType l2)
 {
     if (l1 == LOCK_UPGRADING || l2 == LOCK_UPGRADING)
         return true;
     if (l1 == LOCK_NONE || l2 == LOCK_NONE)
         return false;
+    else if (l1 == LOCK_INC || l2 == LOCK_INC)
+        return l1 != l2;
     else if (l1 == LOCK_EX || l2 == LOCK_EX)
         return true;
     else
@@ -256,9 +413,178 @@ bool Row_lock::conflict_lock(LockType l1, LockType l2)
 bool
 Row_lock::is_owner(TxnManager * txn)
 {
+    uint64_t word = _lock_word;
+    if (word != LOCK_INFLATED)
+        return word == ((uint64_t)txn | LOCK_WORD_EX);
     return _lock_type == LOCK_EX
-        && _locking_set.size() == 1
-        && (*_locking_set.begin()) == txn;
+        && _num_owners == 1
+        && _owners[0] == txn;
+}
+
+#if CC_ALG == DL_DETECT
+void
+Row_lock::get_waits_for(TxnManager * txn, vector<uint64_t> &txn_ids)
+{
+    pthread_mutex_lock( &_latch );
+    // a waiting or upgrading txn always inflates the lock.
+    bool waiting = false;
+    if (_lock_word == LOCK_INFLATED) {
+        waiting = (_lock_type == LOCK_UPGRADING && _upgrading_txn == txn);
+        for (uint32_t i = 0; i < _num_waiters && !waiting; i ++)
+            waiting = (_waiters[i].txn == txn);
+    }
+    if (waiting)
+        for (uint32_t i = 0; i < _num_owners; i ++)
+            if (_owners[i] != txn)
+                txn_ids.push_back(_owners[i]->get_txn_id());
+    pthread_mutex_unlock( &_latch );
+}
+#endif
+
+Row_lock::LockType
+Row_lock::get_lock_type()
+{
+    uint64_t word = _lock_word;
+    if (word == 0)
+        return LOCK_NONE;
+    else if (word == LOCK_INFLATED)
+        return _lock_type;
+    else
+        return (word & LOCK_WORD_EX)? LOCK_EX : LOCK_SH;
+}
+
+void
+Row_lock::inflate()
+{
+    while (true) {
+        uint64_t word = _lock_word;
+        if (word == LOCK_INFLATED)
+            return;
+        // a concurrent fast path release may change the word.
+        if (!ATOM_CAS(_lock_word, word, LOCK_INFLATED))
+            continue;
+        assert(_num_owners == 0);
+        if (word == 0)
+            _lock_type = LOCK_NONE;
+        else {
+            _lock_type = (word & LOCK_WORD_EX)? LOCK_EX : LOCK_SH;
+            add_owner(LOCK_WORD_TXN(word));
+        }
+        return;
+    }
+}
+
+void
+Row_lock::deflate()
+{
+    assert(_lock_word == LOCK_INFLATED);
+#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    if (_num_waiters > 0)
+        return;
+#endif
+    // the lock word cannot encode LOCK_INC.
+    if (_num_owners > 1 || _lock_type == LOCK_UPGRADING || _lock_type == LOCK_INC)
+        return;
+    uint64_t word = 0;
+    if (_num_owners == 1) {
+        word = (uint64_t)_owners[0] | ((_lock_type == LOCK_EX)? LOCK_WORD_EX : 0);
+        _num_owners = 0;
+    }
+    _lock_type = LOCK_NONE;
+    COMPILER_BARRIER
+    _lock_word = word;
+}
+
+bool
+Row_lock::find_owner(TxnManager * txn)
+{
+    for (uint32_t i = 0; i < _num_owners; i ++)
+        if (_owners[i] == txn)
+            return true;
+    return false;
+}
+
+void
+Row_lock::add_owner(TxnManager * txn)
+{
+    assert(!find_owner(txn));
+    if (_num_owners == _max_owners) {
+        TxnManager ** owners = new TxnManager * [_max_owners * 2];
+        memcpy(owners, _owners, sizeof(TxnManager *) * _num_owners);
+        if (_owners != _owner_buf)
+            delete [] _owners;
+        _owners = owners;
+        _max_owners *= 2;
+    }
+    _owners[_num_owners ++] = txn;
+}
+
+bool
+Row_lock::remove_owner(TxnManager * txn)
+{
+    for (uint32_t i = 0; i < _num_owners; i ++) {
+        if (_owners[i] == txn) {
+            _owners[i] = _owners[-- _num_owners];
+            return true;
+        }
+    }
+    return false;
+}
+
+#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+TxnManager *
+Row_lock::oldest_owner()
+{
+    assert(_num_owners > 0);
+    TxnManager * oldest = _owners[0];
+    for (uint32_t i = 1; i < _num_owners; i ++)
+        if (LOCK_MAN(_owners[i])->get_ts() < LOCK_MAN(oldest)->get_ts())
+            oldest = _owners[i];
+    return oldest;
 }
 
+#if CC_ALG == WOUND_WAIT
+void
+Row_lock::wound_owners(TxnManager * txn)
+{
+    uint64_t ts = LOCK_MAN(txn)->get_ts();
+    for (uint32_t i = 0; i < _num_owners; i ++)
+        if (LOCK_MAN(_owners[i])->get_ts() > ts)
+            LOCK_MAN(txn)->wound(_owners[i]);
+}
+#endif
+
+void
+Row_lock::add_waiter(LockType type, TxnManager * txn)
+{
+    // only spills when g_max_num_waits is larger than MAX_NUM_WAITS.
+    if (_num_waiters == _max_waiters) {
+        WaitEntry * waiters = new WaitEntry [_max_waiters * 2];
+        memcpy(waiters, _waiters, sizeof(WaitEntry) * _num_waiters);
+        if (_waiters != _wait_buf)
+            delete [] _waiters;
+        _waiters = waiters;
+        _max_waiters *= 2;
+    }
+    uint64_t ts = LOCK_MAN(txn)->get_ts();
+    uint32_t i = _num_waiters;
+    while (i > 0 && LOCK_MAN(_waiters[i - 1].txn)->get_ts() > ts) {
+        _waiters[i] = _waiters[i - 1];
+        i --;
+    }
+    _waiters[i].type = type;
+    _waiters[i].txn = txn;
+    _num_waiters ++;
+}
+
+void
+Row_lock::remove_waiter(uint32_t idx)
+{
+    assert(idx < _num_waiters);
+    for (uint32_t i = idx; i + 1 < _num_waiters; i ++)
+        _waiters[i] = _waiters[i + 1];
+    _num_waiters --;
+}
+#endif
+
 #endif
@@ -1,64 +1,116 @@
 #pragma once
 
-#include <set>
-
 class TxnManager;
 class CCManager;
 class LockManager;
 class row_t;
 
+// holders and waiters stored in the row before spilling to the heap.
+#define LOCK_INLINE_OWNERS 2
+#define LOCK_INLINE_WAITERS (MAX_NUM_WAITS + 1)
+
 class Row_lock {
 public:
     enum LockType {
         LOCK_EX,
         LOCK_SH,
+        // for INC accesses. Only conflicts with LOCK_EX and LOCK_SH.
+        LOCK_INC,
         LOCK_UPGRADING,
         LOCK_NONE
     };
     Row_lock();
     Row_lock(row_t * row);
-    virtual     ~Row_lock() {}
+    virtual     ~Row_lock();
     virtual void init(row_t * row);
     RC             lock_get(LockType type, TxnManager * txn, bool need_latch = true);
     RC             lock_release(TxnManager * txn, RC rc);
     bool         is_owner(TxnManager * txn);
+#if INC_SUPPORTED
+    // reserve delta for an INC holder. Returns ABORT if the field could leave
+    // [min, max] once any subset of the reserved deltas is applied.
+    RC           escrow_reserve(char * field, double delta, double min, double max);
+    // drop the reservation, and add delta to the field if apply is set.
+    void         escrow_release(char * field, double delta, bool apply);
+#endif
+#if CC_ALG == DL_DETECT
+    // append the txn_id of the holders that txn waits for.
+    void         get_waits_for(TxnManager * txn, vector<uint64_t> &txn_ids);
+#endif
 
     void         latch();
     void         unlatch();
 
     uint32_t     _max_num_waits;
+    // only valid when the lock is inflated.
     LockType     _lock_type;
 protected:
     struct WaitEntry {
         LockType type;
         TxnManager * txn;
     };
-#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT
+#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
     #define LOCK_MAN(txn) ((LockManager *) (txn)->get_cc_manager())
 #elif CC_ALG == F_ONE
     #define LOCK_MAN(txn) ((F1Manager *) (txn)->get_cc_manager())
 #endif
-    // only store timestamp which uniquely identifies a txn.
-    // for NO_WAIT, store the txn_id
-#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE
-    struct CompareLock {
-        bool operator() (TxnManager * txn1, TxnManager * txn2) const;
-    };
-    std::set<TxnManager *, CompareLock >        _locking_set;
+    // Lock word. With at most one holder and no waiters, the lock is only this word:
+    //   0                      free
+    //   txn | LOCK_WORD_EX     held by txn, exclusively if the bit is set
+    // so an uncontended acquire or release is a single CAS. Other states (multiple
+    // holders, waiters, upgrades, LOCK_INC) inflate the lock: _lock_word becomes
+    // LOCK_INFLATED and the fields below, protected by _latch, hold the state.
+    volatile uint64_t _lock_word;
 
-    struct CompareWait {
-        bool operator() (const WaitEntry &en1, const WaitEntry &en2) const;
-    };
-    std::set<WaitEntry, CompareWait>             _waiting_set;
-#else
-    std::set<TxnManager *>                        _locking_set;
+    // holders of an inflated lock, unordered.
+    TxnManager *    _owner_buf[LOCK_INLINE_OWNERS];
+    TxnManager **    _owners;
+    uint32_t        _num_owners;
+    uint32_t        _max_owners;
+#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    // waiters sorted by timestamp, the oldest txn first.
+    WaitEntry        _wait_buf[LOCK_INLINE_WAITERS];
+    WaitEntry *        _waiters;
+    uint32_t        _num_waiters;
+    uint32_t        _max_waiters;
 #endif
     TxnManager *     _upgrading_txn;
+#if INC_SUPPORTED
+    // reserved and not yet applied deltas per field, split by sign. Protected by _latch.
+    struct Escrow {
+        char *      field;
+        double      low;
+        double      high;
+        uint32_t    num_deltas;
+    };
+    vector<Escrow>  _escrows;
+#endif
 
 
     pthread_mutex_t      _latch;
 
     row_t *        _row;
     bool         conflict_lock(LockType l1, LockType l2);
+private:
+    void         init_lock_table();
+    // the type of the lock, from _lock_word or _lock_type.
+    LockType     get_lock_type();
+    // move the state in _lock_word to the inflated fields. Called with _latch held.
+    void         inflate();
+    // go back to the lock word if possible. Called with _latch held.
+    void         deflate();
+
+    bool         find_owner(TxnManager * txn);
+    void         add_owner(TxnManager * txn);
+    bool         remove_owner(TxnManager * txn);
+#if CC_ALG == WAIT_DIE || CC_ALG == F_ONE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    TxnManager * oldest_owner();
+    void         add_waiter(LockType type, TxnManager * txn);
+    void         remove_waiter(uint32_t idx);
+#endif
+#if CC_ALG == WOUND_WAIT
+    // wound the holders younger than txn.
+    void         wound_owners(TxnManager * txn);
+#endif
 };
 //__attribute__ ((aligned(64)));
@@ -0,0 +1,88 @@
+#include "row_silo.h"
+#include "row.h"
+#include "txn.h"
+#include "helper.h"
+
+#if CC_ALG == SILO
+
+Row_silo::Row_silo(row_t * row)
+{
+    _row = row;
+    _tid_word = 0;
+    _latch = NULL;
+    if (!row) {
+        _latch = new pthread_mutex_t;
+        pthread_mutex_init( _latch, NULL );
+    }
+}
+
+RC
+Row_silo::read(TxnManager * txn, char * data, uint64_t &tid)
+{
+    // Copy the tuple between two loads of _tid_word and retry if a writer has
+    // installed a new version in between. A locked tuple can still be read;
+    // the read is then rejected at validation.
+    while (true) {
+        uint64_t v = _tid_word;
+        if (v & SILO_LATCH_BIT) {
+            PAUSE
+            continue;
+        }
+        COMPILER_BARRIER
+        if (data)
+            memcpy(data, _row->get_data(), _row->get_tuple_size());
+        COMPILER_BARRIER
+        if (_tid_word == v) {
+            tid = v & SILO_TID_MASK;
+            return RCOK;
+        }
+        PAUSE
+    }
+}
+
+bool
+Row_silo::try_lock()
+{
+    uint64_t v = _tid_word;
+    if (v & SILO_LOCK_BIT)
+        return false;
+    return ATOM_CAS(_tid_word, v, v | SILO_LOCK_BIT);
+}
+
+void
+Row_silo::release()
+{
+    assert(_tid_word & SILO_LOCK_BIT);
+    // only the lock owner changes a locked word.
+    _tid_word = _tid_word & ~SILO_LOCK_BIT;
+}
+
+void
+Row_silo::write_data(char * data, uint64_t tid)
+{
+    uint64_t v = _tid_word;
+    assert(v & SILO_LOCK_BIT);
+    assert(tid > (v & SILO_TID_MASK) && tid <= SILO_TID_MASK);
+    if (data) {
+        _tid_word = v | SILO_LATCH_BIT;
+        COMPILER_BARRIER
+        _row->copy(data);
+        COMPILER_BARRIER
+    }
+    _tid_word = tid | SILO_LOCK_BIT;
+}
+
+void
+Row_silo::latch()
+{
+    assert(_latch);
+    pthread_mutex_lock( _latch );
+}
+
+void
+Row_silo::unlatch()
+{
+    pthread_mutex_unlock( _latch );
+}
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "global.h"
+
+#if CC_ALG == SILO
+
+// TID word: | LOCK_BIT | LATCH_BIT | TID (62 bits) |
+// LOCK_BIT is held by a committing txn from its lock phase to the end of 2PC.
+// LATCH_BIT is only held while the tuple is being written; readers spin on it.
+// TID = | epoch (30 bits) | sequence number (32 bits) |
+#define SILO_LOCK_BIT        (1UL << 63)
+#define SILO_LATCH_BIT       (1UL << 62)
+#define SILO_TID_MASK        (SILO_LATCH_BIT - 1)
+#define SILO_EPOCH_SHIFT     32
+
+class TxnManager;
+class row_t;
+
+class Row_silo {
+public:
+    Row_silo() : Row_silo(NULL) {};
+    Row_silo(row_t * row);
+
+    // copy the tuple without any lock. tid is the version that was copied.
+    RC                 read(TxnManager * txn, char * data, uint64_t &tid);
+    uint64_t         get_tid() { return _tid_word & SILO_TID_MASK; }
+    // the TID and the lock bit must be checked on the same load for validation.
+    uint64_t         get_tid_word() { return _tid_word; }
+
+    // no wait. return false if the tuple is locked by another txn.
+    bool             try_lock();
+    void             release();
+    // the caller holds the lock. Install a new version of the tuple.
+    // For an index bucket, data is NULL and only the TID is updated.
+    void             write_data(char * data, uint64_t tid);
+
+    // only index buckets use the latch, to protect the bucket structure.
+    void             latch();
+    void             unlatch();
+private:
+    row_t *                 _row;
+    volatile uint64_t        _tid_word;
+    pthread_mutex_t *        _latch;
+} __attribute__ ((aligned(64)));
+
+#endif
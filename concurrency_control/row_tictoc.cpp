@@ -6,9 +6,17 @@
 #include "manager.h"
 #include "stdlib.h"
 #include "table.h"
+#include "caching.h"
 
 #if CC_ALG==TICTOC
 
+#if ATOMIC_WORD
+static_assert(!TICTOC_MV && !TRACK_LAST, "ATOMIC_WORD does not keep the history of timestamps");
+#endif
+#if CACHE_PUSH
+static_assert(ENABLE_LOCAL_CACHING, "CACHE_PUSH pushes to the local caches");
+#endif
+
 #if MULTI_VERSION
 int Row_tictoc::_history_num = 30;
 #endif
@@ -25,11 +33,16 @@ Row_tictoc::Row_tictoc(row_t * row)
 {
     _row = row;
     _latch = new pthread_mutex_t;
-    _blatch = false;
     pthread_mutex_init( _latch, NULL );
+#if ATOMIC_WORD
+    _ts_word = 0;
+    _rts = 0;
+#else
+    _blatch = false;
     _wts = 0;
     _rts = 0;
-    _ts_lock = false;
+#endif
+    set_ts_lock(false);
     _num_remote_reads = 0;
   #if OCC_LOCK_TYPE == WAIT_DIE || OCC_WAW_LOCK
       _max_num_waits = g_max_num_waits;
@@ -40,14 +53,53 @@ Row_tictoc::Row_tictoc(row_t * row)
 #endif
     _deleted = false;
     _delete_timestamp = 0;
+#if ADAPTIVE_LEASE
+    // a tuple that has not been written gets the max lease.
+    _write_intvl = 2 * MAX_LEASE;
+#endif
+#if CACHE_PUSH
+    _sharers = 0;
+#endif
 }
 
 RC
 Row_tictoc::read(TxnManager * txn, char * data,
                  uint64_t &wts, uint64_t &rts, bool latch, bool remote)
 {
+#if ATOMIC_WORD
+    // Optimistic read without the latch. Copy the tuple between two loads of
+    // _ts_word and retry if a writer has changed the tuple in between.
+    while (true) {
+        uint64_t v = load_word(rts);
+        wts = v & WTS_MASK;
+        if (data)
+            memcpy(data, _row->get_data(), _row->get_tuple_size());
+        COMPILER_BARRIER
+        if ((_ts_word & ~WRITE_BIT) == (v & ~WRITE_BIT))
+            break;
+        PAUSE
+    }
+    if (txn->is_sub_txn())
+        _num_remote_reads ++;
+  #if ADAPTIVE_LEASE
+    // fails if the tuple is locked or has changed. Then rts is unchanged.
+    extend_rts(wts, lease_rts(wts, rts), rts, true);
+  #endif
+  #if ENABLE_LOCAL_CACHING && RO_LEASE
+    if (_row && remote) {
+        uint64_t max_rts = _row->get_table()->get_max_rts();
+        if (max_rts > rts)
+            extend_rts(wts, max_rts, rts, true);
+    }
+  #endif
+    return RCOK;
+#else
     if (latch)
         this->latch();
+  #if ADAPTIVE_LEASE
+    if (!_ts_lock)
+        _rts = lease_rts(_wts, _rts);
+  #endif
     wts = _wts;
     rts = _rts;
     if (data)
@@ -67,6 +119,7 @@ Row_tictoc::read(TxnManager * txn, char * data,
     if (latch)
         unlatch();
     return RCOK;
+#endif
 }
 
 RC
@@ -81,7 +134,7 @@ Row_tictoc::write(TxnManager * txn, uint64_t &wts, uint64_t &rts, bool latch)
     if (latch)
         pthread_mutex_lock( _latch );
       if (!_ts_lock) {
-        _ts_lock = true;
+        set_ts_lock(true);
         _lock_owner = txn;
     } else if (_lock_owner != txn) {
 #if OCC_LOCK_TYPE == NO_WAIT
@@ -103,8 +156,12 @@ Row_tictoc::write(TxnManager * txn, uint64_t &wts, uint64_t &rts, bool latch)
 #endif
     }
     if (rc == RCOK) {
+#if ATOMIC_WORD
+        get_ts(wts, rts);
+#else
         wts = _wts;
         rts = _rts;
+#endif
     }
     if (latch)
         pthread_mutex_unlock( _latch );
@@ -114,6 +171,14 @@ Row_tictoc::write(TxnManager * txn, uint64_t &wts, uint64_t &rts, bool latch)
 RC
 Row_tictoc::update(char * data, uint64_t wts, uint64_t rts)
 {
+#if ATOMIC_WORD
+    uint64_t v = latch_word();
+    if (wts > (v & WTS_MASK)) {
+        _row->set_data(data);
+        v = encode_word(v, wts, rts);
+    }
+    unlatch_word(v);
+#else
     if (wts > _wts) {
         pthread_mutex_lock( _latch );
         _wts = wts;
@@ -121,16 +186,24 @@ Row_tictoc::update(char * data, uint64_t wts, uint64_t rts)
         _row->set_data(data);
         pthread_mutex_unlock( _latch );
     }
+#endif
     return RCOK;
 }
 
 void
 Row_tictoc::update_rts(uint64_t rts)
 {
+#if ATOMIC_WORD
+    uint64_t v = latch_word();
+    if (rts > decode_rts(v))
+        v = encode_word(v, v & WTS_MASK, rts);
+    unlatch_word(v);
+#else
     pthread_mutex_lock( _latch );
     if (rts > _rts)
         _rts = rts;
     pthread_mutex_unlock( _latch );
+#endif
 }
 
 void
@@ -149,16 +222,23 @@ void
 Row_tictoc::write_data(char * data, ts_t wts)
 {
 #if ATOMIC_WORD
-    // TODO. asserts can be removed for performance.
-    assert(_ex_lock);
-    assert(wts > _wts);
-
-    _wts = wts | LOCK_BIT; // the tuple is being modified.
-    COMPILER_BARRIER
-    _rts = wts;
+    // the caller holds the write lock. LOCK_BIT makes concurrent readers retry.
+    assert(_ts_lock);
+    uint64_t v = latch_word();
+    assert(wts > (v & WTS_MASK));
+    if (_deleted)
+        assert(wts < _delete_timestamp);
     _row->copy(data);
-    COMPILER_BARRIER
-    _wts = wts;                // wts/rts and data are consistent.
+  #if ADAPTIVE_LEASE
+    predict_lease(v & WTS_MASK, wts);
+  #endif
+    unlatch_word(encode_word(v, wts, wts));
+  #if UPDATE_TABLE_TS
+    _row->get_table()->update_max_wts(wts);
+  #endif
+  #if CACHE_PUSH
+    push_to_sharers(wts, 0);
+  #endif
 #else
     latch();
   #if TRACK_LAST
@@ -174,6 +254,9 @@ Row_tictoc::write_data(char * data, ts_t wts)
   #endif
     if (_deleted)
         assert(wts < _delete_timestamp);
+  #if ADAPTIVE_LEASE
+    predict_lease(_wts, wts);
+  #endif
 
     _wts = wts;
     _rts = wts;
@@ -183,23 +266,41 @@ Row_tictoc::write_data(char * data, ts_t wts)
   #if UPDATE_TABLE_TS
     _row->get_table()->update_max_wts(_wts);
   #endif
+  #if CACHE_PUSH
+    push_to_sharers(wts, 0);
+  #endif
 #endif
 }
 
 void
 Row_tictoc::update_ts(uint64_t cts)
 {
+#if ATOMIC_WORD
+    uint64_t v = latch_word();
+    assert(cts > decode_rts(v));
+  #if ADAPTIVE_LEASE
+    predict_lease(v & WTS_MASK, cts);
+  #endif
+    unlatch_word(encode_word(v, cts, cts));
+#else
     latch();
     assert(cts > _rts);
+  #if ADAPTIVE_LEASE
+    predict_lease(_wts, cts);
+  #endif
     _wts = cts;
     _rts = cts;
     unlatch();
+#endif
 }
 
 bool
 Row_tictoc::try_renew(ts_t rts)
 {
     assert(false);
+#if ATOMIC_WORD
+    return false;
+#else
     if (rts < _wts) {
         if (rts + 1 < _wts)
             INC_INT_STATS(int_possibMVCC, 1);  // multiple version in between.
@@ -213,57 +314,41 @@ Row_tictoc::try_renew(ts_t rts)
     }
     pthread_mutex_unlock( _latch );
     return success;
+#endif
 }
 
 bool
 Row_tictoc::try_renew(ts_t wts, ts_t rts, ts_t &new_rts)
 {
 #if ATOMIC_WORD
-    uint64_t v = _ts_word;
-    uint64_t lock_mask = (WRITE_PERMISSION_LOCK)? WRITE_BIT : LOCK_BIT;
-    if ((v & WTS_MASK) == wts && ((v & RTS_MASK) >> WTS_LEN) >= rts - wts)
-        return true;
-    if (v & lock_mask)
-        return false;
-  #if TICTOC_MV
-      COMPILER_BARRIER
-      uint64_t hist_wts = _hist_wts;
-    if (wts != (v & WTS_MASK)) {
-        if (wts == hist_wts && rts < (v & WTS_MASK)) {
-            return true;
-        } else {
-            return false;
+    if (_deleted)
+        return (wts == get_wts() && rts < _delete_timestamp);
+    if (extend_rts(wts, lease_rts(wts, rts), new_rts, true)) {
+  #if ENABLE_LOCAL_CACHING && RO_LEASE
+        if (_row) {
+            uint64_t max_rts = _row->get_table()->get_max_rts();
+            if (max_rts > new_rts)
+                extend_rts(wts, max_rts, new_rts, true);
         }
-    }
-  #else
-    if (wts != (v & WTS_MASK))
-        return false;
   #endif
-
-    ts_t delta_rts = rts - wts;
-    if (delta_rts < ((v & RTS_MASK) >> WTS_LEN)) // the rts has already been extended.
+  #if CACHE_PUSH
+        push_to_sharers(wts, new_rts);
+  #endif
         return true;
-    bool rebase = false;
-    if (delta_rts >= (1 << RTS_LEN)) {
-        rebase = true;
-        uint64_t delta = (delta_rts & ~((1 << RTS_LEN) - 1));
-        delta_rts &= ((1 << RTS_LEN) - 1);
-        wts += delta;
     }
-    uint64_t v2 = 0;
-    v2 |= wts;
-    v2 |= (delta_rts << WTS_LEN);
-    while (true) {
-        uint64_t pre_v = __sync_val_compare_and_swap(&_ts_word, v, v2);
-        if (pre_v == v)
-            return true;
-        v = pre_v;
-        if (rebase || (v & lock_mask) || (wts != (v & WTS_MASK)))
-            return false;
-        else if (rts < ((v & RTS_MASK) >> WTS_LEN))
-            return true;
+    uint64_t cur_wts = get_wts();
+    if (cur_wts == wts) {
+        INC_INT_STATS(int_aborts_rs3, 1);  // Locked by others
+    } else {
+        if (cur_wts < rts)
+            INC_INT_STATS(int_inevitable, 1);
+        if (cur_wts == rts + 1) {
+            INC_INT_STATS(int_aborts_rs2, 1);  // The latest version is right behind our version.
+        } else {
+            INC_INT_STATS(int_possibMVCC, 1);
+            INC_INT_STATS(int_aborts_rs1, 1);
+        }
     }
-    assert(false);
     return false;
 #else
     if (wts != _wts) {
@@ -343,6 +428,7 @@ Row_tictoc::try_renew(ts_t wts, ts_t rts, ts_t &new_rts)
         pthread_mutex_unlock( _latch );
         return false;
     }
+    rts = lease_rts(wts, rts);
       new_rts = _rts;
     if (rts > _rts) {
         _rts = rts;
@@ -359,6 +445,9 @@ Row_tictoc::try_renew(ts_t wts, ts_t rts, ts_t &new_rts)
 #endif
 
     pthread_mutex_unlock( _latch );
+  #if CACHE_PUSH
+    push_to_sharers(wts, new_rts);
+  #endif
     return true;
 #endif
 }
@@ -368,52 +457,12 @@ Row_tictoc::renew(ts_t wts, ts_t rts, ts_t &new_rts) // Renew without lock check
 {
 #if LOCK_ALL_BEFORE_COMMIT
 #if ATOMIC_WORD
-    uint64_t v = _ts_word;
-    uint64_t lock_mask = (WRITE_PERMISSION_LOCK)? WRITE_BIT : LOCK_BIT;
-    if ((v & WTS_MASK) == wts && ((v & RTS_MASK) >> WTS_LEN) >= rts - wts)
-        return true;
-    if (v & lock_mask)
-        return false;
-  #if TICTOC_MV
-      COMPILER_BARRIER
-      uint64_t hist_wts = _hist_wts;
-    if (wts != (v & WTS_MASK)) {
-        if (wts == hist_wts && rts < (v & WTS_MASK)) {
-            return true;
-        } else {
-            return false;
-        }
-    }
-  #else
-    if (wts != (v & WTS_MASK))
+    if (!extend_rts(wts, lease_rts(wts, rts), new_rts, false))
         return false;
+  #if CACHE_PUSH
+    push_to_sharers(wts, new_rts);
   #endif
-
-    ts_t delta_rts = rts - wts;
-    if (delta_rts < ((v & RTS_MASK) >> WTS_LEN)) // the rts has already been extended.
-        return true;
-    bool rebase = false;
-    if (delta_rts >= (1 << RTS_LEN)) {
-        rebase = true;
-        uint64_t delta = (delta_rts & ~((1 << RTS_LEN) - 1));
-        delta_rts &= ((1 << RTS_LEN) - 1);
-        wts += delta;
-    }
-    uint64_t v2 = 0;
-    v2 |= wts;
-    v2 |= (delta_rts << WTS_LEN);
-    while (true) {
-        uint64_t pre_v = __sync_val_compare_and_swap(&_ts_word, v, v2);
-        if (pre_v == v)
-            return true;
-        v = pre_v;
-        if (rebase || (v & lock_mask) || (wts != (v & WTS_MASK)))
-            return false;
-        else if (rts < ((v & RTS_MASK) >> WTS_LEN))
-            return true;
-    }
-    assert(false);
-    return false;
+    return true;
 #else
 #if TICTOC_MV
     if (wts < _hist_wts)
@@ -439,6 +488,7 @@ Row_tictoc::renew(ts_t wts, ts_t rts, ts_t &new_rts) // Renew without lock check
         pthread_mutex_unlock( _latch );
         return false;
     }
+    rts = lease_rts(wts, rts);
     new_rts = _rts;
     if (rts > _rts) {
         _rts = rts;
@@ -455,6 +505,9 @@ Row_tictoc::renew(ts_t wts, ts_t rts, ts_t &new_rts) // Renew without lock check
 #endif
 
     pthread_mutex_unlock( _latch );
+  #if CACHE_PUSH
+    push_to_sharers(wts, new_rts);
+  #endif
     return true;
 #endif
 #else
@@ -477,8 +530,9 @@ ts_t
 Row_tictoc::get_rts()
 {
 #if ATOMIC_WORD
-    uint64_t v = _ts_word;
-    return ((v & RTS_MASK) >> WTS_LEN) + (v & WTS_MASK);
+    uint64_t rts;
+    load_word(rts);
+    return rts;
 #else
     return _rts;
 #endif
@@ -487,36 +541,37 @@ Row_tictoc::get_rts()
 void
 Row_tictoc::get_ts(uint64_t &wts, uint64_t &rts)
 {
+#if ATOMIC_WORD
+    wts = load_word(rts) & WTS_MASK;
+#else
     pthread_mutex_lock( _latch );
     wts = _wts;
     rts = _rts;
     pthread_mutex_unlock( _latch );
+#endif
 }
 
 void
 Row_tictoc::set_ts(uint64_t wts, uint64_t rts)
 {
+#if ATOMIC_WORD
+    uint64_t v = latch_word();
+    unlatch_word(encode_word(v, wts, rts));
+#else
     pthread_mutex_lock( _latch );
     _wts = wts;
     _rts = rts;
     pthread_mutex_unlock( _latch );
+#endif
 }
 
 void
 Row_tictoc::lock()
 {
-#if ATOMIC_WORD
-    uint64_t lock_mask = (WRITE_PERMISSION_LOCK)? WRITE_BIT : LOCK_BIT;
-    uint64_t v = _ts_word;
-    while ((v & lock_mask) || !__sync_bool_compare_and_swap(&_ts_word, v, v | lock_mask)) {
-        PAUSE
-        v = _ts_word;
-    }
-#else
     pthread_mutex_lock( _latch );
-    assert( __sync_bool_compare_and_swap(&_ts_lock, false, true) );
+    assert(!_ts_lock);
+    set_ts_lock(true);
     pthread_mutex_unlock( _latch );
-#endif
 }
 
 bool
@@ -537,13 +592,13 @@ Row_tictoc::try_lock(TxnManager * txn)
     assert(!OCC_WAW_LOCK);
 #if OCC_LOCK_TYPE == NO_WAIT
       if (!_ts_lock) {
-        _ts_lock = true;
+        set_ts_lock(true);
         rc = RCOK;
     } else
         rc = ABORT;
 #elif OCC_LOCK_TYPE == WAIT_DIE
       if (!_ts_lock) {
-        _ts_lock = true;
+        set_ts_lock(true);
         assert(_lock_owner == NULL);
         _lock_owner = txn;
         rc = RCOK;
@@ -572,7 +627,7 @@ Row_tictoc::release(TxnManager * txn, RC rc)
     pthread_mutex_lock( _latch );
 #if !OCC_WAW_LOCK
   #if OCC_LOCK_TYPE == NO_WAIT
-    _ts_lock = false;
+    set_ts_lock(false);
   #elif OCC_LOCK_TYPE == WAIT_DIE
     if (rc == RCOK)
         assert(_ts_lock && txn == _lock_owner);
@@ -592,11 +647,11 @@ Row_tictoc::release(TxnManager * txn, RC rc)
                     (*it)->set_txn_ready(ABORT);
                 }
                 _waiting_set.clear();
-                _ts_lock = false;
+                set_ts_lock(false);
                 _lock_owner = NULL;
             }
         } else {
-            _ts_lock = false;
+            set_ts_lock(false);
             _lock_owner = NULL;
         }
     } else {
@@ -615,7 +670,7 @@ Row_tictoc::release(TxnManager * txn, RC rc)
 
     assert(_ts_lock);
   #if OCC_LOCK_TYPE == NO_WAIT
-    _ts_lock = false;
+    set_ts_lock(false);
   #elif OCC_LOCK_TYPE == WAIT_DIE
     if (_waiting_set.size() > 0) {
         set<TxnManager *>::iterator last = _waiting_set.end();
@@ -636,7 +691,7 @@ Row_tictoc::release(TxnManager * txn, RC rc)
         COMPILER_BARRIER
         next->set_txn_ready(RCOK);
     } else {
-        _ts_lock = false;
+        set_ts_lock(false);
         _lock_owner = NULL;
     }
   #endif
@@ -644,6 +699,171 @@ Row_tictoc::release(TxnManager * txn, RC rc)
     pthread_mutex_unlock( _latch );
 }
 
+void
+Row_tictoc::set_ts_lock(bool lock)
+{
+    _ts_lock = lock;
+#if ATOMIC_WORD
+    // publish the lock to the lock-free renewals.
+    while (true) {
+        uint64_t v = wait_word();
+        uint64_t v2 = lock? (v | WRITE_BIT) : (v & ~WRITE_BIT);
+        if (ATOM_CAS(_ts_word, v, v2))
+            break;
+    }
+#endif
+}
+
+#if ATOMIC_WORD
+uint64_t
+Row_tictoc::wait_word()
+{
+    uint64_t v = _ts_word;
+    while (v & LOCK_BIT) {
+        PAUSE
+        v = _ts_word;
+    }
+    COMPILER_BARRIER
+    return v;
+}
+
+uint64_t
+Row_tictoc::latch_word()
+{
+    while (true) {
+        uint64_t v = wait_word();
+        if (ATOM_CAS(_ts_word, v, v | LOCK_BIT))
+            return v;
+    }
+}
+
+void
+Row_tictoc::unlatch_word(uint64_t v)
+{
+    COMPILER_BARRIER
+    _ts_word = v & ~LOCK_BIT;
+}
+
+uint64_t
+Row_tictoc::encode_word(uint64_t v, uint64_t wts, uint64_t rts)
+{
+    M_ASSERT(wts <= WTS_MASK, "wts=%ld does not fit in WTS_LEN bits\n", wts);
+    assert(rts >= wts);
+    uint64_t delta = rts - wts;
+    if (delta >= RTS_EXT) {
+        _rts = rts;
+        delta = RTS_EXT;
+    }
+    return (v & WRITE_BIT) | (delta << WTS_LEN) | wts;
+}
+
+uint64_t
+Row_tictoc::decode_rts(uint64_t v)
+{
+    uint64_t delta = (v & RTS_MASK) >> WTS_LEN;
+    if (delta == RTS_EXT)
+        return _rts;
+    return (v & WTS_MASK) + delta;
+}
+
+uint64_t
+Row_tictoc::load_word(uint64_t &rts)
+{
+    while (true) {
+        uint64_t v = wait_word();
+        rts = decode_rts(v);
+        if (((v & RTS_MASK) >> WTS_LEN) != RTS_EXT)
+            return v;
+        // _rts may belong to a newer version.
+        COMPILER_BARRIER
+        if (_ts_word == v)
+            return v;
+    }
+}
+
+bool
+Row_tictoc::extend_rts(uint64_t wts, uint64_t rts, uint64_t &new_rts, bool check_lock)
+{
+    while (true) {
+        uint64_t cur_rts;
+        uint64_t v = load_word(cur_rts);
+        if ((v & WTS_MASK) != wts)
+            return false;
+        if (rts <= cur_rts) {
+            new_rts = cur_rts;
+            return true;
+        }
+        if (check_lock && (v & WRITE_BIT))
+            return false;
+        uint64_t delta = rts - wts;
+        if (delta < RTS_EXT) {
+            uint64_t v2 = (v & ~RTS_MASK) | (delta << WTS_LEN);
+            if (ATOM_CAS(_ts_word, v, v2)) {
+                new_rts = rts;
+                return true;
+            }
+            continue;
+        }
+        // the delta overflows. Fall back to the full rts in _rts, which is only
+        // written with LOCK_BIT held.
+        if (!ATOM_CAS(_ts_word, v, v | LOCK_BIT))
+            continue;
+        new_rts = max(decode_rts(v), rts);
+        unlatch_word(encode_word(v, wts, new_rts));
+        return true;
+    }
+}
+#endif
+
+#if CACHE_PUSH
+void
+Row_tictoc::add_sharer(uint32_t node_id)
+{
+    uint64_t bit = 1UL << node_id;
+    uint64_t sharers = _sharers;
+    while (!(sharers & bit) && !ATOM_CAS(_sharers, sharers, sharers | bit))
+        sharers = _sharers;
+}
+
+void
+Row_tictoc::push_to_sharers(uint64_t wts, uint64_t rts)
+{
+    if (!_sharers || !_row)
+        return;
+    uint64_t sharers = _sharers;
+    // after an invalidation, a node is a sharer again when it reads the new version.
+    if (rts == 0)
+        while (!ATOM_CAS(_sharers, sharers, 0))
+            sharers = _sharers;
+    local_cache_man->push(sharers, _row->get_primary_key(), wts, rts);
+}
+#endif
+
+#if ADAPTIVE_LEASE
+void
+Row_tictoc::predict_lease(uint64_t old_wts, uint64_t wts)
+{
+    assert(wts > old_wts);
+    uint64_t intvl = wts - old_wts;
+    if (intvl > 2 * MAX_LEASE)
+        intvl = 2 * MAX_LEASE;
+    _write_intvl = (_write_intvl * 3 + intvl) / 4;
+}
+#endif
+
+uint64_t
+Row_tictoc::lease_rts(uint64_t wts, uint64_t rts)
+{
+#if ADAPTIVE_LEASE
+    // a lease shorter than the expected life of the version rarely delays the next
+    // writer, and saves the renewals of the readers that commit within it.
+    uint64_t lease = min(_write_intvl / 2, (uint64_t)MAX_LEASE);
+    return max(rts, wts + lease);
+#else
+    return rts;
+#endif
+}
+
 void
 Row_tictoc::delete_row(uint64_t del_ts)
 {
@@ -654,7 +874,9 @@ Row_tictoc::delete_row(uint64_t del_ts)
 }
 
 
-#if MULTI_VERSION
+// TRACK_LAST is not supported with ATOMIC_WORD.
+#if ATOMIC_WORD
+#elif MULTI_VERSION
 void Row_tictoc::get_last_array(ts_t* & last_rts_array, ts_t* & last_wts_array, int & last_ptr)
 {
     last_rts_array = _lastrts_array;
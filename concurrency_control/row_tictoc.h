@@ -4,14 +4,21 @@
 
 #if CC_ALG == TICTOC
 
-#if WRITE_PERMISSION_LOCK
+#if ATOMIC_WORD || WRITE_PERMISSION_LOCK
 
+// [ATOMIC_WORD] The timestamps and the locks of a tuple are packed in _ts_word.
+//    | LOCK_BIT | WRITE_BIT | rts - wts (RTS_LEN) | wts (WTS_LEN) |
+// LOCK_BIT is held for a short time while the tuple or its timestamps are being
+// modified; readers retry. WRITE_BIT is the write lock (_ts_lock); readers may
+// proceed but the rts cannot be extended.
 #define LOCK_BIT (1UL << 63)
 #define WRITE_BIT (1UL << 62)
-#define RTS_LEN (15)
+#define RTS_LEN (14)
 #define WTS_LEN (62 - RTS_LEN)
 #define WTS_MASK ((1UL << WTS_LEN) - 1)
 #define RTS_MASK (((1UL << RTS_LEN) - 1) << WTS_LEN)
+// the delta does not fit in RTS_LEN bits. The rts is kept in _rts instead.
+#define RTS_EXT ((1UL << RTS_LEN) - 1)
 
 #else
 
@@ -81,6 +88,10 @@ public:
 
 #if ENABLE_LOCAL_CACHING
     bool                 is_read_intensive() { return _write_intensity == 0; }
+#endif
+#if CACHE_PUSH
+    // node_id caches the tuple.
+    void                add_sharer(uint32_t node_id);
 #endif
     bool                 is_deleted() { return _deleted; }
     void                 delete_row(uint64_t del_ts);
@@ -93,14 +104,11 @@ public:
 
     row_t *             _row;
 #if ATOMIC_WORD
-    //volatile uint64_t    _ts_word;
-    // the first bit in _wts is the write_latch bit, indicating that the tuple is being written to.
-    volatile uint64_t    _wts; // last write timestamp.
-    volatile uint64_t    _rts; // end lease timestamp
-    volatile bool         _write_latch;
-    // when locked, only the owner can change wts/rts.
-    // however, the tuple can still be read by other txns.
-    volatile bool        _ex_lock;
+    volatile uint64_t    _ts_word;
+    // the rts when the delta in _ts_word is RTS_EXT. Only written with LOCK_BIT held.
+    volatile uint64_t    _rts;
+    pthread_mutex_t *     _latch;        // protects _lock_owner and _waiting_set
+    bool                _ts_lock;
 #else
     uint64_t            _wts; // last write timestamp
     uint64_t            _rts; // end lease timestamp
@@ -129,6 +137,42 @@ public:
 #endif
     // for locality predictor
     uint32_t             _num_remote_reads; // should cache a local copy if this number is too large.
+private:
+#if ADAPTIVE_LEASE
+    // moving average of the wts distance between consecutive versions.
+    uint64_t            _write_intvl;
+    // update _write_intvl when version wts replaces version old_wts.
+    void                predict_lease(uint64_t old_wts, uint64_t wts);
+#endif
+#if CACHE_PUSH
+    // nodes caching the tuple, one bit per node. Cleared when the tuple is written.
+    volatile uint64_t    _sharers;
+    // push the new rts of version wts to the sharers, or the invalidation if
+    // rts == 0. The sharers are cleared on invalidation.
+    void                push_to_sharers(uint64_t wts, uint64_t rts);
+#endif
+    // the rts to extend version wts to, at least rts. With ADAPTIVE_LEASE, the
+    // version is leased for half of the predicted write interval.
+    uint64_t            lease_rts(uint64_t wts, uint64_t rts);
+    // also sets/clears WRITE_BIT with ATOMIC_WORD. Called with _latch held.
+    void                set_ts_lock(bool lock);
+#if ATOMIC_WORD
+    // spin until LOCK_BIT is clear. Returns the word.
+    uint64_t            wait_word();
+    // acquire LOCK_BIT. Returns the word without LOCK_BIT.
+    uint64_t            latch_word();
+    // publish a new word and release LOCK_BIT.
+    void                unlatch_word(uint64_t v);
+    // build a word for (wts, rts), keeping WRITE_BIT of v. Called with LOCK_BIT held.
+    uint64_t            encode_word(uint64_t v, uint64_t wts, uint64_t rts);
+    // rts of the version in v. If rts is in _rts, the caller should recheck _ts_word.
+    uint64_t            decode_rts(uint64_t v);
+    // returns an unlocked word and the rts of its version.
+    uint64_t            load_word(uint64_t &rts);
+    // extend the rts of version wts to at least rts. Fails if the version has
+    // changed, or if check_lock is true and WRITE_BIT is set.
+    bool                extend_rts(uint64_t wts, uint64_t rts, uint64_t &new_rts, bool check_lock);
+#endif
 };
 // __attribute__ ((aligned(64)));
 
@@ -0,0 +1,184 @@
+#include "sequencer.h"
+#include "manager.h"
+#include "helper.h"
+
+#if CC_ALG == CALVIN
+
+Sequencer::Sequencer()
+{
+    pthread_mutex_init(&_latch, NULL);
+    _num_local_txns = 0;
+    _local_epoch = 0;
+    _epoch = 0;
+    _batches = new map<uint64_t, string> [g_num_server_nodes];
+}
+
+void
+Sequencer::submit(uint64_t txn_id, vector<LockRequest> &locks)
+{
+    // a txn locks each key once, in the strongest mode.
+    map<uint64_t, LockRequest> unique_locks;
+    for (auto &lock : locks) {
+        map<uint64_t, LockRequest>::iterator it = unique_locks.find(lock.key);
+        if (it == unique_locks.end())
+            unique_locks[lock.key] = lock;
+        else if (lock.type == WR)
+            it->second.type = WR;
+    }
+    uint32_t num_locks = unique_locks.size();
+    pthread_mutex_lock(&_latch);
+    _local_batch.put( &txn_id );
+    _local_batch.put( &num_locks );
+    for (auto &it : unique_locks) {
+        _local_batch.put( &it.second.key );
+        _local_batch.put( &it.second.node_id );
+        _local_batch.put( &it.second.type );
+    }
+    _num_local_txns ++;
+    pthread_mutex_unlock(&_latch);
+}
+
+void
+Sequencer::close_batch(uint32_t &size, char * &data)
+{
+    pthread_mutex_lock(&_latch);
+    UnstructuredBuffer buffer;
+    buffer.put( &_local_epoch );
+    buffer.put( &_num_local_txns );
+    buffer.put( (char *)_local_batch.data(), _local_batch.size() );
+    _batches[g_node_id][_local_epoch] = string(buffer.data(), buffer.size());
+    _local_epoch ++;
+    _local_batch = UnstructuredBuffer();
+    _num_local_txns = 0;
+    schedule();
+    pthread_mutex_unlock(&_latch);
+
+    size = buffer.size();
+    data = new char [size];
+    memcpy(data, buffer.data(), size);
+}
+
+void
+Sequencer::add_batch(uint32_t node_id, uint32_t size, char * data)
+{
+    uint64_t epoch;
+    UnstructuredBuffer buffer(data);
+    buffer.get( &epoch );
+    pthread_mutex_lock(&_latch);
+    assert(epoch >= _epoch);
+    _batches[node_id][epoch] = string(data, size);
+    schedule();
+    pthread_mutex_unlock(&_latch);
+}
+
+void
+Sequencer::schedule()
+{
+    while (true) {
+        for (uint32_t i = 0; i < g_num_server_nodes; i ++)
+            if (_batches[i].find(_epoch) == _batches[i].end())
+                return;
+        for (uint32_t i = 0; i < g_num_server_nodes; i ++) {
+            schedule_batch(_batches[i][_epoch]);
+            _batches[i].erase(_epoch);
+        }
+        _epoch ++;
+    }
+}
+
+void
+Sequencer::schedule_batch(string &batch)
+{
+    UnstructuredBuffer buffer((char *)batch.data());
+    uint64_t epoch;
+    uint32_t num_txns;
+    buffer.get( &epoch );
+    buffer.get( &num_txns );
+    for (uint32_t i = 0; i < num_txns; i ++) {
+        uint64_t txn_id;
+        uint32_t num_locks;
+        buffer.get( &txn_id );
+        buffer.get( &num_locks );
+        vector<LockRequest> local_locks;
+        for (uint32_t j = 0; j < num_locks; j ++) {
+            LockRequest lock;
+            buffer.get( &lock.key );
+            buffer.get( &lock.node_id );
+            buffer.get( &lock.type );
+            if (lock.node_id == g_node_id)
+                local_locks.push_back(lock);
+        }
+        // the home node keeps a txn without local locks, since the txn waits for its
+        // batch to be scheduled.
+        if (local_locks.empty() && glob_manager->txnid_to_server_node(txn_id) != g_node_id)
+            continue;
+        if (_released.erase(txn_id) > 0)
+            continue;
+        assert(_txns.find(txn_id) == _txns.end());
+        TxnLocks &txn = _txns[txn_id];
+        txn.num_waits = local_locks.size();
+        for (auto &lock : local_locks) {
+            LockEntry entry = {txn_id, lock.type, false};
+            _lock_table[lock.key].push_back(entry);
+            txn.keys.push_back(lock.key);
+        }
+        for (auto &lock : local_locks)
+            grant(lock.key);
+    }
+}
+
+void
+Sequencer::grant(uint64_t key)
+{
+    vector<LockEntry> &queue = _lock_table[key];
+    for (uint32_t i = 0; i < queue.size(); i ++) {
+        // a writer is only granted at the head of the queue, and readers are granted
+        // together until the first writer.
+        if (queue[i].type == WR && i > 0)
+            break;
+        if (!queue[i].granted) {
+            queue[i].granted = true;
+            _txns[queue[i].txn_id].num_waits --;
+        }
+        if (queue[i].type == WR)
+            break;
+    }
+}
+
+bool
+Sequencer::is_granted(uint64_t txn_id)
+{
+    pthread_mutex_lock(&_latch);
+    map<uint64_t, TxnLocks>::iterator it = _txns.find(txn_id);
+    bool granted = (it != _txns.end() && it->second.num_waits == 0);
+    pthread_mutex_unlock(&_latch);
+    return granted;
+}
+
+void
+Sequencer::release(uint64_t txn_id)
+{
+    pthread_mutex_lock(&_latch);
+    map<uint64_t, TxnLocks>::iterator it = _txns.find(txn_id);
+    if (it == _txns.end()) {
+        _released.insert(txn_id);
+        pthread_mutex_unlock(&_latch);
+        return;
+    }
+    for (auto key : it->second.keys) {
+        vector<LockEntry> &queue = _lock_table[key];
+        for (vector<LockEntry>::iterator entry = queue.begin(); entry != queue.end(); entry ++)
+            if (entry->txn_id == txn_id) {
+                queue.erase(entry);
+                break;
+            }
+        if (queue.empty())
+            _lock_table.erase(key);
+        else
+            grant(key);
+    }
+    _txns.erase(it);
+    pthread_mutex_unlock(&_latch);
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "global.h"
+#include "query.h"
+#include "packetize.h"
+
+#if CC_ALG == CALVIN
+
+// Deterministic lock scheduling for CALVIN.
+// Each node collects its new txns into a batch, which worker thread 0 closes every
+// CALVIN_EPOCH_INTERVAL and sends to all the other nodes. Once a node has the batches of
+// an epoch from every node, it queues the locks on this node in the global order
+//   (epoch, node_id, position in the batch)
+// and grants each lock in its queue order. So all the nodes agree on the order of
+// conflicting txns; a txn only waits for earlier txns, and there is no deadlock.
+//
+// Batch format (also used in CALVIN_BATCH):
+//   | epoch | n | (txn_id, num_locks, (key, node_id, type) * num_locks) * n |
+class Sequencer {
+public:
+    Sequencer();
+    // add a new txn of this node to the current batch.
+    void         submit(uint64_t txn_id, vector<LockRequest> &locks);
+    // close the current batch and schedule it. data is the batch to send to the other
+    // nodes. Called by a single thread.
+    void         close_batch(uint32_t &size, char * &data);
+    void         add_batch(uint32_t node_id, uint32_t size, char * data);
+
+    // whether all the locks of the txn on this node are granted.
+    bool         is_granted(uint64_t txn_id);
+    // release all the locks of the txn on this node. A txn may be released before its
+    // batch is scheduled, e.g., if it aborts before accessing this node.
+    void         release(uint64_t txn_id);
+private:
+    struct LockEntry {
+        uint64_t     txn_id;
+        access_t     type;
+        bool         granted;
+    };
+    struct TxnLocks {
+        vector<uint64_t>     keys;
+        uint32_t             num_waits;
+    };
+    // the following functions are called with the latch held.
+    void         schedule();
+    void         schedule_batch(string &batch);
+    void         grant(uint64_t key);
+
+    pthread_mutex_t              _latch;
+    UnstructuredBuffer           _local_batch;
+    uint32_t                     _num_local_txns;
+    uint64_t                     _local_epoch;
+    // the next epoch to schedule.
+    uint64_t                     _epoch;
+    // per node, the batches received but not scheduled yet.
+    map<uint64_t, string> *      _batches;
+
+    map<uint64_t, vector<LockEntry>>     _lock_table;
+    map<uint64_t, TxnLocks>              _txns;
+    set<uint64_t>                        _released;
+};
+
+#endif
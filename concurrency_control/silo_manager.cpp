@@ -0,0 +1,496 @@
+#include "silo_manager.h"
+#include "row_silo.h"
+#include "row.h"
+#include "txn.h"
+#include "manager.h"
+#include "workload.h"
+#include "index_hash.h"
+#include "table.h"
+#include "packetize.h"
+
+#if CC_ALG == SILO
+
+__thread uint64_t SiloManager::_last_tid = 0;
+
+SiloManager::SiloManager(TxnManager * txn)
+    : CCManager(txn)
+{
+    _is_read_only = true;
+    _max_tid = 0;
+    _commit_tid = 0;
+#if WORKLOAD == TPCC
+    _access_set.reserve(128);
+#endif
+}
+
+void
+SiloManager::init()
+{
+    CCManager::init();
+    _is_read_only = true;
+    _max_tid = 0;
+    _commit_tid = 0;
+}
+
+RC
+SiloManager::get_row(row_t * row, access_t type, uint64_t key)
+{
+    assert(type == RD || type == WR);
+    AccessSilo * access = NULL;
+    for (vector<AccessSilo>::iterator it = _access_set.begin(); it != _access_set.end(); it ++) {
+        if (it->row == row) {
+            access = &(*it);
+            break;
+        }
+    }
+    if (!access) {
+        AccessSilo ac;
+        _access_set.push_back(ac);
+        access = &(*_access_set.rbegin());
+        access->home_node_id = g_node_id;
+        access->row = row;
+        access->type = type;
+        access->key = key;
+        access->table_id = row->get_table()->get_table_id();
+        access->data_size = row->get_tuple_size();
+        access->local_data = new char [access->data_size];
+        row->manager->read(_txn, access->local_data, access->tid);
+        _max_tid = max(_max_tid, access->tid);
+    }
+    // a tuple that is read and then written is validated as a write.
+    if (type == WR) {
+        access->type = WR;
+        _is_read_only = false;
+    }
+    _last_access = access;
+    return RCOK;
+}
+
+RC
+SiloManager::get_row(row_t * row, access_t type, char * &data, uint64_t key)
+{
+    uint64_t tt = get_sys_clock();
+    RC rc = get_row(row, type, key);
+    data = _last_access->local_data;
+    INC_FLOAT_STATS(row, get_sys_clock() - tt);
+    return rc;
+}
+
+char *
+SiloManager::get_data(uint64_t key, uint32_t table_id)
+{
+    for (vector<AccessSilo>::iterator it = _access_set.begin(); it != _access_set.end(); it ++)
+        if (it->key == key && it->table_id == table_id)
+            return it->local_data;
+
+    for (vector<AccessSilo>::iterator it = _remote_set.begin(); it != _remote_set.end(); it ++)
+        if (it->key == key && it->table_id == table_id)
+            return it->local_data;
+
+    assert(false);
+    return NULL;
+}
+
+RC
+SiloManager::register_remote_access(uint32_t remote_node_id, access_t type, uint64_t key, uint32_t table_id)
+{
+    AccessSilo ac;
+    _remote_set.push_back(ac);
+    AccessSilo * access = &(*_remote_set.rbegin());
+    assert(remote_node_id != g_node_id);
+
+    access->home_node_id = remote_node_id;
+    access->type = type;
+    access->key = key;
+    access->table_id = table_id;
+    add_remote_node_info(remote_node_id, type == WR);
+    return LOCAL_MISS;
+}
+
+RC
+SiloManager::index_get_permission(access_t type, INDEX * index, uint64_t key, uint32_t limit)
+{
+    // An index bucket is versioned like a tuple. Reads record the TID of the bucket,
+    // and inserts/deletes lock the bucket in the lock phase and bump its TID at commit.
+    IndexAccessSilo ac;
+    _index_access_set.push_back(ac);
+    IndexAccessSilo * access = &(*_index_access_set.rbegin());
+    access->key = key;
+    access->index = index;
+    access->type = type;
+
+    // the bucket is latched in the following function.
+    Row_silo * manager = index->index_get_manager(key);
+    access->manager = manager;
+    manager->read(_txn, NULL, access->tid);
+    _max_tid = max(_max_tid, access->tid);
+    if (type == RD) {
+        set<row_t *> * rows = index->read(key);
+        if (rows) {
+            if (rows->size() > limit) {
+                set<row_t *>::iterator it = rows->begin();
+                advance(it, limit);
+                access->rows = new set<row_t *>( rows->begin(), it );
+            } else
+                access->rows = new set<row_t *>( *rows );
+        }
+    } else
+        _is_read_only = false;
+    manager->unlatch();
+    return RCOK;
+}
+
+RC
+SiloManager::index_read(INDEX * index, uint64_t key, set<row_t *> * &rows, uint32_t limit)
+{
+    uint64_t tt = get_sys_clock();
+    RC rc = index_get_permission(RD, index, key, limit);
+    rows = _index_access_set.rbegin()->rows;
+    INC_FLOAT_STATS(index, get_sys_clock() - tt);
+    return rc;
+}
+
+RC
+SiloManager::index_insert(INDEX * index, uint64_t key)
+{
+    uint64_t tt = get_sys_clock();
+    RC rc = index_get_permission(INS, index, key);
+    INC_FLOAT_STATS(index, get_sys_clock() - tt);
+    return rc;
+}
+
+RC
+SiloManager::index_delete(INDEX * index, uint64_t key)
+{
+    uint64_t tt = get_sys_clock();
+    RC rc = index_get_permission(DEL, index, key);
+    INC_FLOAT_STATS(index, get_sys_clock() - tt);
+    return rc;
+}
+
+void
+SiloManager::cleanup(RC rc)
+{
+    for (vector<AccessSilo>::iterator it = _access_set.begin(); it != _access_set.end(); it ++) {
+        if (it->locked)
+            it->row->manager->release();
+        delete [] it->local_data;
+    }
+    for (vector<AccessSilo>::iterator it = _remote_set.begin(); it != _remote_set.end(); it ++)
+        delete [] it->local_data;
+    for (vector<IndexAccessSilo>::iterator it = _index_access_set.begin();
+         it != _index_access_set.end(); it ++)
+    {
+        if (it->locked)
+            it->manager->release();
+        delete it->rows;
+    }
+    if (rc == ABORT)
+        for (auto ins : _inserts)
+            delete ins.row;
+    _access_set.clear();
+    _remote_set.clear();
+    _index_access_set.clear();
+    _inserts.clear();
+    _deletes.clear();
+}
+
+void
+SiloManager::get_resp_data(uint32_t &size, char * &data)
+{
+    // construct the return message.
+    // Format:
+    //    | n | (key, table_id, tuple_size, data) * n
+    // The TIDs stay at this node, where the reads are validated.
+    UnstructuredBuffer buffer;
+    uint32_t num_tuples = 0;
+    for (vector<AccessSilo>::iterator it = _access_set.begin(); it != _access_set.end(); it ++) {
+        if (it->responded) continue;
+        buffer.put( &it->key );
+        buffer.put( &it->table_id );
+        buffer.put( &it->data_size );
+        buffer.put( it->local_data, it->data_size );
+        it->responded = true;
+        num_tuples ++;
+    }
+    assert(num_tuples > 0);
+    buffer.put_front( &num_tuples );
+    size = buffer.size();
+    data = new char [size];
+    memcpy(data, buffer.data(), size);
+}
+
+SiloManager::AccessSilo *
+SiloManager::find_access(uint64_t key, uint32_t table_id, vector<AccessSilo> * set)
+{
+    for (vector<AccessSilo>::iterator it = set->begin(); it != set->end(); it ++) {
+        if (it->key == key && it->table_id == table_id)
+            return &(*it);
+    }
+    return NULL;
+}
+
+void
+SiloManager::process_remote_resp(uint32_t node_id, uint32_t size, char * resp_data)
+{
+    // return data format:
+    //        | n | (key, table_id, tuple_size, data) * n
+    UnstructuredBuffer buffer(resp_data);
+    uint32_t num_tuples;
+    buffer.get( &num_tuples );
+    assert(num_tuples > 0);
+    for (uint32_t i = 0; i < num_tuples; i++) {
+        uint64_t key;
+        uint32_t table_id;
+        buffer.get( &key );
+        buffer.get( &table_id );
+        AccessSilo * access = find_access(key, table_id, &_remote_set);
+        assert(access && node_id == access->home_node_id);
+        buffer.get( &access->data_size );
+        char * data = NULL;
+        buffer.get( data, access->data_size );
+        access->local_data = new char [access->data_size];
+        memcpy(access->local_data, data, access->data_size);
+    }
+}
+
+// Lock the tuples and index buckets in the write set. No wait.
+// The locks are released in cleanup().
+RC
+SiloManager::lock_write_set()
+{
+    for (vector<AccessSilo>::iterator it = _access_set.begin(); it != _access_set.end(); it ++) {
+        if (it->type != WR)
+            continue;
+        if (!it->row->manager->try_lock())
+            return ABORT;
+        it->locked = true;
+        // every write in a store procedure is a read-modify-write.
+        if (it->row->manager->get_tid() != it->tid)
+            return ABORT;
+    }
+    for (uint32_t i = 0; i < _index_access_set.size(); i ++) {
+        IndexAccessSilo &access = _index_access_set[i];
+        if (access.type == RD)
+            continue;
+        // several keys may share a bucket.
+        bool locked = false;
+        for (uint32_t j = 0; j < i; j ++)
+            if (_index_access_set[j].manager == access.manager && _index_access_set[j].locked)
+                locked = true;
+        if (locked)
+            continue;
+        if (!access.manager->try_lock())
+            return ABORT;
+        access.locked = true;
+        access.tid = access.manager->get_tid();
+        _max_tid = max(_max_tid, access.tid);
+    }
+    return RCOK;
+}
+
+RC
+SiloManager::validate_read_set()
+{
+    for (vector<AccessSilo>::iterator it = _access_set.begin(); it != _access_set.end(); it ++) {
+        if (it->type != RD)
+            continue;
+        // a tuple is accessed once, so a locked tuple in the read set is locked by another txn.
+        if (it->row->manager->get_tid_word() != it->tid)
+            return ABORT;
+    }
+    for (vector<IndexAccessSilo>::iterator it = _index_access_set.begin();
+         it != _index_access_set.end(); it ++)
+    {
+        if (it->type != RD)
+            continue;
+        uint64_t v = it->manager->get_tid_word();
+        if ((v & SILO_TID_MASK) != it->tid)
+            return ABORT;
+        if (v & SILO_LOCK_BIT) {
+            bool locked = false;
+            for (auto &access : _index_access_set)
+                if (access.manager == it->manager && access.locked)
+                    locked = true;
+            if (!locked)
+                return ABORT;
+        }
+    }
+    return RCOK;
+}
+
+void
+SiloManager::compute_commit_tid()
+{
+    if (_commit_tid > 0)
+        return;
+    uint64_t epoch_tid = glob_manager->get_epoch() << SILO_EPOCH_SHIFT;
+    _commit_tid = max(max(_max_tid, _last_tid) + 1, epoch_tid);
+    _last_tid = _commit_tid;
+}
+
+RC
+SiloManager::process_lock_phase_coord()
+{
+    RC rc = lock_write_set();
+    if (rc == ABORT)
+        INC_INT_STATS(num_aborts_ws, 1);  // local abort
+    return rc;
+}
+
+RC
+SiloManager::process_lock_req(uint32_t size, char * data, uint32_t &resp_size, char * &resp_data)
+{
+    assert(size == 0);
+    RC rc = lock_write_set();
+    if (rc == ABORT)
+        cleanup(ABORT);
+    return rc;
+}
+
+void
+SiloManager::process_lock_resp(RC rc, uint32_t node_id, char * data)
+{
+}
+
+RC
+SiloManager::process_prepare_phase_coord()
+{
+    RC rc = validate_read_set();
+    if (rc == ABORT)
+        INC_INT_STATS(num_aborts_rs, 1);  // local abort
+    return rc;
+}
+
+RC
+SiloManager::process_prepare_req(uint32_t size, char * data, uint32_t &resp_size, char * &resp_data)
+{
+    RC rc = validate_read_set();
+    if (rc == ABORT) {
+        cleanup(ABORT);
+        return ABORT;
+    }
+    // Format:
+    //  | max_tid |
+    resp_size = sizeof(_max_tid);
+    resp_data = new char [resp_size];
+    memcpy(resp_data, &_max_tid, resp_size);
+    if (is_read_only()) {
+        cleanup(COMMIT);
+        return COMMIT;
+    }
+    return RCOK;
+}
+
+void
+SiloManager::process_prepare_resp(RC rc, uint32_t node_id, char * data)
+{
+    if (rc == RCOK) {
+        uint64_t max_tid;
+        memcpy(&max_tid, data, sizeof(max_tid));
+        _max_tid = max(_max_tid, max_tid);
+    }
+}
+
+void
+SiloManager::process_commit_phase_coord(RC rc)
+{
+    if (rc == COMMIT) {
+        compute_commit_tid();
+        commit_insdel();
+        for (vector<AccessSilo>::iterator it = _access_set.begin(); it != _access_set.end(); it ++)
+            if (it->type == WR)
+                it->row->manager->write_data(it->local_data, _commit_tid);
+        for (vector<IndexAccessSilo>::iterator it = _index_access_set.begin();
+             it != _index_access_set.end(); it ++)
+        {
+            if (it->locked)
+                it->manager->write_data(NULL, _commit_tid);
+        }
+    }
+    cleanup(rc);
+}
+
+RC
+SiloManager::commit_insdel()
+{
+    for (auto ins : _inserts) {
+        row_t * row = ins.row;
+        set<INDEX *> indexes;
+        ins.table->get_indexes( &indexes );
+        for (auto idx : indexes) {
+            uint64_t key = row->get_index_key(idx);
+            idx->insert(key, row);
+        }
+    }
+    for (auto row : _deletes) {
+        set<INDEX *> indexes;
+        row->get_table()->get_indexes( &indexes );
+        for (auto idx : indexes)
+            idx->remove( row );
+    }
+    return RCOK;
+}
+
+bool
+SiloManager::need_commit_req(RC rc, uint32_t node_id, uint32_t &size, char * &data)
+{
+    if (rc == ABORT)
+        return true;
+    compute_commit_tid();
+    // Format
+    //   | commit_tid | num_writes | (key, table_id, size, data) * num_writes
+    UnstructuredBuffer buffer;
+    uint32_t num_writes = 0;
+    for (vector<AccessSilo>::iterator it = _remote_set.begin(); it != _remote_set.end(); it ++)
+        if (it->home_node_id == node_id && it->type == WR)
+            num_writes ++;
+    buffer.put( &_commit_tid );
+    buffer.put( &num_writes );
+    for (vector<AccessSilo>::iterator it = _remote_set.begin(); it != _remote_set.end(); it ++)
+        if (it->home_node_id == node_id && it->type == WR) {
+            buffer.put( &it->key );
+            buffer.put( &it->table_id );
+            buffer.put( &it->data_size );
+            buffer.put( it->local_data, it->data_size );
+        }
+    size = buffer.size();
+    data = new char [size];
+    memcpy(data, buffer.data(), size);
+    return true;
+}
+
+void
+SiloManager::process_commit_req(RC rc, uint32_t size, char * data)
+{
+    if (rc == COMMIT) {
+        // Format
+        //   | commit_tid | num_writes | (key, table_id, size, data) * num_writes
+        UnstructuredBuffer buffer(data);
+        uint32_t num_writes;
+        buffer.get( &_commit_tid );
+        buffer.get( &num_writes );
+        for (uint32_t i = 0; i < num_writes; i ++) {
+            uint64_t key;
+            uint32_t table_id;
+            uint32_t tuple_size = 0;
+            char * tuple_data = NULL;
+            buffer.get( &key );
+            buffer.get( &table_id );
+            buffer.get( &tuple_size );
+            buffer.get( tuple_data, tuple_size );
+            AccessSilo * access = find_access( key, table_id, &_access_set );
+            assert(access && access->locked);
+            access->row->manager->write_data(tuple_data, _commit_tid);
+        }
+    }
+    cleanup(rc);
+}
+
+void
+SiloManager::abort()
+{
+    cleanup(ABORT);
+}
+
+#endif
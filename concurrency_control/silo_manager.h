@@ -0,0 +1,96 @@
+#pragma once
+
+#include "cc_manager.h"
+
+#if CC_ALG == SILO
+
+// Silo-style OCC. Reads record the TID of a tuple without any lock. Before 2PC, the
+// lock phase locks the write set on every node (no wait). The prepare phase then
+// validates the read set on every node: a read is valid if the TID is unchanged and the
+// tuple is not locked by another txn. Validating only after all the write locks are
+// held makes the protocol serializable across nodes.
+// The commit TID is larger than any TID read or written, larger than the last TID of
+// the coordinator thread, and at least in the current epoch of the coordinator node.
+class SiloManager : public CCManager
+{
+public:
+    SiloManager(TxnManager * txn);
+    ~SiloManager() {};
+
+    void         init();
+    bool        is_read_only() { return _is_read_only; }
+
+    RC             get_row(row_t * row, access_t type, uint64_t key);
+    RC             get_row(row_t * row, access_t type, char * &data, uint64_t key);
+    char *         get_data(uint64_t key, uint32_t table_id);
+    RC             register_remote_access(uint32_t remote_node_id, access_t type, uint64_t key, uint32_t table_id);
+
+    RC             index_get_permission(access_t type, INDEX * index, uint64_t key, uint32_t limit = -1);
+    RC             index_read(INDEX * index, uint64_t key, set<row_t *> * &rows, uint32_t limit = -1);
+    RC            index_insert(INDEX * index, uint64_t key);
+    RC            index_delete(INDEX * index, uint64_t key);
+
+    void         cleanup(RC rc);
+
+    // normal execution
+    void         get_resp_data(uint32_t &size, char * &data);
+    void         process_remote_resp(uint32_t node_id, uint32_t size, char * resp_data);
+
+    // lock phase
+    RC             process_lock_phase_coord();
+    RC             process_lock_req(uint32_t size, char * data, uint32_t &resp_size, char * &resp_data);
+    void         process_lock_resp(RC rc, uint32_t node_id, char * data);
+
+    // prepare phase
+    RC             process_prepare_phase_coord();
+    RC             process_prepare_req(uint32_t size, char * data, uint32_t &resp_size, char * &resp_data);
+    void         process_prepare_resp(RC rc, uint32_t node_id, char * data);
+
+    // commit phase
+    void         process_commit_phase_coord(RC rc);
+    RC            commit_insdel();
+    bool         need_commit_req(RC rc, uint32_t node_id, uint32_t &size, char * &data);
+    void         process_commit_req(RC rc, uint32_t size, char * data);
+    void         abort();
+
+    bool         is_txn_ready() { return true; }
+private:
+    struct IndexAccessSilo : IndexAccess {
+        uint64_t     tid;
+    };
+
+    struct AccessSilo : Access {
+        AccessSilo() {
+            locked = false;
+            responded = false;
+            row = NULL;
+            local_data = NULL;
+        };
+        bool         locked;
+        uint64_t     tid;
+        uint32_t     data_size;
+        char *         local_data;
+        // only for sub txns
+        bool         responded;
+    };
+
+    AccessSilo * find_access(uint64_t key, uint32_t table_id, vector<AccessSilo> * set);
+
+    RC             lock_write_set();
+    RC             validate_read_set();
+    void         compute_commit_tid();
+
+    bool                        _is_read_only;
+    vector<AccessSilo>            _access_set;
+    vector<AccessSilo>            _remote_set;
+    vector<IndexAccessSilo>        _index_access_set;
+    AccessSilo *                 _last_access;
+
+    // the largest TID read or written on all the nodes.
+    uint64_t                     _max_tid;
+    uint64_t                     _commit_tid;
+    // the last TID chosen by the thread.
+    static __thread uint64_t     _last_tid;
+};
+
+#endif
@@ -41,8 +41,6 @@ TicTocManager::TicTocManager(TxnManager * txn)
     _signal_abort = false;
     _min_commit_ts = 0;
 
-    LEASE = 10;
-
     if (!_txn->is_sub_txn()) {
         _min_commit_ts = glob_manager->get_max_cts();
         // arbitrary parameter.
@@ -213,6 +211,11 @@ TicTocManager::get_row(row_t * row, access_t type, uint64_t key, uint64_t wts)
             if (access->wts == wts) {
                 access->cached = true;
             }
+  #if CACHE_PUSH
+            // the requesting node caches the tuple it reads.
+            if (type == RD && _txn->is_sub_txn())
+                row->manager->add_sharer(_txn->get_src_node_id());
+  #endif
 #endif
         } else {
             assert(type == WR && OCC_WAW_LOCK);
@@ -1062,6 +1065,9 @@ TicTocManager::process_prepare_req(uint32_t size, char * data, uint32_t &resp_si
                 char data[size];
                 uint64_t wts, rts;
                 row->manager->read(_txn, data, wts, rts);
+  #if CACHE_PUSH
+                row->manager->add_sharer(_txn->get_src_node_id());
+  #endif
 
                 buffer.put( &wts );
                 buffer.put( &rts );
@@ -1198,7 +1204,7 @@ TicTocManager::process_prepare_resp(RC rc, uint32_t node_id, char * data)
         } else {
             local_cache_man->vote_local();
             buffer.get( &rts );
-            local_cache_man->update(key, rts);
+            local_cache_man->update(key, access->wts, rts);
             if (access->cached)
                 INC_INT_STATS(num_renew_success, 1);
         }
@@ -1280,7 +1286,7 @@ TicTocManager::commit_insdel() {
     }
     for (auto access : _index_access_set)
         if (access.type != RD) {
-            assert(_min_commit_ts > access.manager->_rts);
+            assert(_min_commit_ts > access.manager->get_rts());
             M_ASSERT(access.manager->_lock_owner == _txn, "lock_owner=%#lx, _txn=%#lx",
                 (uint64_t)access.manager->_lock_owner, (uint64_t)_txn);
             access.manager->update_ts(_min_commit_ts);
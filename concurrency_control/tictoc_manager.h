@@ -61,7 +61,6 @@ public:
     bool         is_txn_ready();
     bool         is_signal_abort() { return _signal_abort; }
 
-    uint64_t     LEASE;
     uint32_t     get_log_record(char *& record);
 private:
     bool         _is_read_only;
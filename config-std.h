@@ -27,7 +27,7 @@
 ////////////////////////////////////////////////////////////////////////
 // Concurrency Control
 ////////////////////////////////////////////////////////////////////////
-// WAIT_DIE, NO_WAIT, TICTOC, F_ONE, MAAT
+// WAIT_DIE, NO_WAIT, WOUND_WAIT, DL_DETECT, TICTOC, F_ONE, MAAT, SILO, CALVIN
 #define CC_ALG                         TICTOC
 #define ISOLATION_LEVEL             SERIALIZABLE
 
@@ -37,6 +37,9 @@
 #define BUCKET_CNT                    31
 #define MAX_NUM_ABORTS                0
 #define ABORT_PENALTY                 1000000
+#define ADAPTIVE_BACKOFF              false
+#define MAX_ABORT_PENALTY             32000000
+#define HOT_KEY_ABORTS                4
 #define ABORT_BUFFER_SIZE            10
 #define ABORT_BUFFER_ENABLE            true
 // [ INDEX ]
@@ -48,6 +51,7 @@
 
 // [Two Phase Locking]
 #define NO_LOCK                        false // NO_LOCK=true : used to model H-Store
+#define DL_DETECT_INTERVAL            1000 // in us
 // [TIMESTAMP]
 #define TS_ALLOC                    TS_CLOCK
 #define TS_BATCH_ALLOC                false
@@ -72,12 +76,16 @@
 #define SKIP_READONLY_PREPARE        false
 #define MAX_NUM_WAITS                4
 #define READ_INTENSITY_THRESH         0.8
+#define ADAPTIVE_LEASE              false
+#define MAX_LEASE                   1000
 
 // [Caching in TicToc]
 #define ENABLE_LOCAL_CACHING         false
 #define CACHING_POLICY                ALWAYS_CHECK
 #define RO_LEASE                    false
 #define LOCAL_CACHE_SIZE            (1024*1024) // in KB
+#define CACHE_ADMISSION             false
+#define CACHE_PUSH                  false
 #define REUSE_FRESH_DATA            false
 #define REUSE_IF_NO_REMOTE             false
 
@@ -91,6 +99,10 @@
 #define PRE_ABORT                    true
 #define ATOMIC_WORD                    false
 #define UPDATE_TABLE_TS                true
+// [SILO]
+#define SILO_EPOCH_INTERVAL            40 // in ms
+// [CALVIN]
+#define CALVIN_EPOCH_INTERVAL        1000 // in us
 // [MAAT]
 #define DEBUG_REFCOUNT                false
 // [HSTORE]
@@ -139,6 +151,7 @@
 #define NUM_WH                         1
 // TODO. REPLICATE_ITEM_TABLE = false only works for TICTOC.
 #define REPLICATE_ITEM_TABLE        true
+#define COMMUTATIVE_INC             false
 
 #define PERC_PAYMENT                 0.316
 #define PERC_NEWORDER                 0.331
@@ -209,6 +222,10 @@ extern TestCases                    g_test_case;
 #define NAIVE_TICTOC                6
 #define TICTOC                        7
 #define TCM                            8
+#define WOUND_WAIT                    9
+#define DL_DETECT                    10
+#define SILO                          11
+#define CALVIN                        12
 //Isolation Levels
 #define SERIALIZABLE                1
 #define SNAPSHOT                    2
@@ -218,9 +235,14 @@ extern TestCases                    g_test_case;
 #define TS_CAS                        2
 #define TS_HW                        3
 #define TS_CLOCK                    4
+#define TS_HLC                      5
 // Commit protocol
 #define TWO_PHASE_COMMIT            1
 #define OWNERSHIP                    2
+// Transport
+#define TRANSPORT_TCP                1
+#define TRANSPORT_SHM                2
+#define TRANSPORT_URING                3
 // Caching policy
 #define ALWAYS_READ                    1    // always read cached data
 #define ALWAYS_CHECK                2    // always contact remote node
@@ -233,11 +255,18 @@ extern TestCases                    g_test_case;
 #define INOUT_QUEUE_SIZE            1024
 #define NUM_INPUT_THREADS            1
 #define NUM_OUTPUT_THREADS            1
-#define MAX_NUM_ACTIVE_TXNS            128
+#define MAX_NUM_ACTIVE_TXNS            1
 #define ENABLE_MSG_BUFFER            false
+#define MSG_BUFFER_MAX_DELAY        20 // in us
 #define MAX_MESSAGE_SIZE             16384
 #define RECV_BUFFER_SIZE             32768
 #define SEND_BUFFER_SIZE             32768
 #define MODEL_DUMMY_MSG                false
+#define RECV_BUSY_POLL                false
+#define TRANSPORT_TYPE                TRANSPORT_TCP
+#define SHM_RING_SIZE                (1024 * 1024)
+#define NET_EMU_DELAY                0 // in us
+#define NET_EMU_JITTER                0 // in us
+#define NET_EMU_BANDWIDTH            0 // in Mbps
 
 #define MAX_CLOCK_SKEW                0 // in us
@@ -24,7 +24,7 @@
 
 // Concurrency Control
 // ===================
-// Supported concurrency control algorithms: WAIT_DIE, NO_WAIT, TICTOC, F_ONE, MAAT
+// Supported concurrency control algorithms: WAIT_DIE, NO_WAIT, WOUND_WAIT, DL_DETECT, TICTOC, F_ONE, MAAT, SILO, CALVIN
 #define CC_ALG WAIT_DIE
 #define ISOLATION_LEVEL SERIALIZABLE
 
@@ -36,6 +36,12 @@
 #define BUCKET_CNT 31
 #define MAX_NUM_ABORTS 0
 #define ABORT_PENALTY 1000000
+// ADAPTIVE_BACKOFF: the penalty of an aborted txn grows exponentially with its aborts and
+// with the abort rate of its txn type, up to MAX_ABORT_PENALTY (in ns). Retries that
+// conflicted on a key with HOT_KEY_ABORTS recent aborts (halved every 10 ms) are serialized.
+#define ADAPTIVE_BACKOFF false
+#define MAX_ABORT_PENALTY 32000000
+#define HOT_KEY_ABORTS 4
 #define ABORT_BUFFER_SIZE 10
 #define ABORT_BUFFER_ENABLE true
 // [ INDEX ]
@@ -47,7 +53,11 @@
 
 // [Two Phase Locking]
 #define NO_LOCK false // NO_LOCK=true : used to model H-Store
+// DL_DETECT_INTERVAL: how often (in us) the waits-for edges are exchanged and searched for cycles.
+#define DL_DETECT_INTERVAL 1000
 // [TIMESTAMP]
+// TS_ALLOC: TS_HLC is a hybrid logical clock; every message carries the clock of its
+// sender, which the receiver's clock never falls behind.
 #define TS_ALLOC TS_CLOCK
 #define TS_BATCH_ALLOC false
 #define TS_BATCH_NUM 1
@@ -72,12 +82,23 @@
 #define SKIP_READONLY_PREPARE        false
 #define MAX_NUM_WAITS                4
 #define READ_INTENSITY_THRESH         0.8
+// ADAPTIVE_LEASE: a read or renewal extends the rts of a tuple by a lease predicted
+// from the interval between its recent writes, at most MAX_LEASE (in timestamps).
+#define ADAPTIVE_LEASE              false
+#define MAX_LEASE                   1000
 
 // [Caching in TicToc]
 #define ENABLE_LOCAL_CACHING         false
 #define CACHING_POLICY                ALWAYS_CHECK
 #define RO_LEASE                    false
 #define LOCAL_CACHE_SIZE            (1024*1024) // in KB
+// CACHE_ADMISSION: when a bank is full, a new tuple is only cached if it has been
+// accessed more often than the eviction victim (TinyLFU).
+#define CACHE_ADMISSION             false
+// CACHE_PUSH: the home node of a tuple tracks the nodes caching it, and pushes
+// invalidations when it is written and rts extensions when it is renewed.
+// A cached tuple is then read locally while its lease covers the txn.
+#define CACHE_PUSH                  false
 #define REUSE_FRESH_DATA            false
 #define REUSE_IF_NO_REMOTE             false
 
@@ -89,8 +110,16 @@
 // [TICTOC, SILO]
 #define OCC_LOCK_TYPE                 WAIT_DIE
 #define PRE_ABORT                    true
+// ATOMIC_WORD: [TICTOC] pack wts, rts and the locks of a tuple in one 64-bit word.
+// Reads and renewals do not take the row latch.
 #define ATOMIC_WORD                    false
 #define UPDATE_TABLE_TS                true
+// [SILO]
+// SILO_EPOCH_INTERVAL: how often (in ms) the global epoch is advanced.
+#define SILO_EPOCH_INTERVAL 40
+// [CALVIN]
+// CALVIN_EPOCH_INTERVAL: how often (in us) the sequencer closes the batch of new txns.
+#define CALVIN_EPOCH_INTERVAL 1000
 // [MAAT]
 #define DEBUG_REFCOUNT                false
 // [HSTORE]
@@ -139,6 +168,10 @@
 #define NUM_WH 8
 // TODO. REPLICATE_ITEM_TABLE = false only works for TICTOC.
 #define REPLICATE_ITEM_TABLE        true
+// COMMUTATIVE_INC: Payment adds to W_YTD and D_YTD with INC accesses, which commute with
+// each other. The bounds of the columns are kept by escrow reservations. Only 2PL supports
+// them; the other algorithms use writes.
+#define COMMUTATIVE_INC false
 
 #define PERC_PAYMENT                 0.316
 #define PERC_NEWORDER                 0.331
@@ -209,6 +242,10 @@ extern TestCases                    g_test_case;
 #define NAIVE_TICTOC                6
 #define TICTOC                        7
 #define TCM                            8
+#define WOUND_WAIT                    9
+#define DL_DETECT                    10
+#define SILO                          11
+#define CALVIN                        12
 //Isolation Levels
 #define SERIALIZABLE                1
 #define SNAPSHOT                    2
@@ -218,9 +255,14 @@ extern TestCases                    g_test_case;
 #define TS_CAS                        2
 #define TS_HW                        3
 #define TS_CLOCK                    4
+#define TS_HLC                      5
 // Commit protocol
 #define TWO_PHASE_COMMIT            1
 #define OWNERSHIP                    2
+// Transport
+#define TRANSPORT_TCP                1
+#define TRANSPORT_SHM                2
+#define TRANSPORT_URING                3
 // Caching policy
 #define ALWAYS_READ                    1    // always read cached data
 #define ALWAYS_CHECK                2    // always contact remote node
@@ -233,11 +275,33 @@ extern TestCases                    g_test_case;
 #define INOUT_QUEUE_SIZE 1024
 #define NUM_INPUT_THREADS 1
 #define NUM_OUTPUT_THREADS 1
-#define MAX_NUM_ACTIVE_TXNS 128
+// max number of native txns a server thread runs concurrently. A txn waiting for
+// a remote node is parked while the thread starts or resumes others.
+#define MAX_NUM_ACTIVE_TXNS 1
 #define ENABLE_MSG_BUFFER false
+// [ENABLE_MSG_BUFFER] hard cap on how long a message may wait in a send buffer.
+// Each destination adapts its flush deadline to the message arrival rate below this cap.
+#define MSG_BUFFER_MAX_DELAY 20 // in us
 #define MAX_MESSAGE_SIZE 16384
 #define RECV_BUFFER_SIZE 32768
 #define SEND_BUFFER_SIZE 32768
 #define MODEL_DUMMY_MSG false
+// RECV_BUSY_POLL: when set to true, input threads spin over all sockets.
+// Otherwise, they sleep in epoll_wait until a socket becomes readable.
+#define RECV_BUSY_POLL false
+// TRANSPORT_TCP: one socket per remote node listed in ifconfig.txt.
+// TRANSPORT_SHM: shared memory rings between processes on the same host. Each process
+//                is started with its node id (-Dn).
+// TRANSPORT_URING: same sockets as TRANSPORT_TCP, driven by io_uring.
+#define TRANSPORT_TYPE TRANSPORT_TCP
+// [TRANSPORT_SHM] bytes per ring, must be a power of two.
+#define SHM_RING_SIZE (1024 * 1024)
+// Network emulation. Bytes sent to each remote node are held in a delay queue, so a
+// cluster on one host behaves like nodes in different datacenters. 0 disables a knob.
+// NET_EMU_JITTER is drawn uniformly from [-NET_EMU_JITTER, NET_EMU_JITTER].
+// Per-link values can be given in a file (-De), see Transport::init_net_emu().
+#define NET_EMU_DELAY 0 // one-way, in us
+#define NET_EMU_JITTER 0 // in us
+#define NET_EMU_BANDWIDTH 0 // per link, in Mbps
 
 #define MAX_CLOCK_SKEW 0 // in us
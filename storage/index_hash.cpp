@@ -9,6 +9,8 @@
 #include "row_maat.h"
 #include "row_ideal_mvcc.h"
 #include "row_tcm.h"
+#include "row_silo.h"
+#include "row_calvin.h"
 #include "manager.h"
 
 IndexHash::IndexHash(bool is_key_index)
@@ -11,6 +11,8 @@
 #include "row_maat.h"
 #include "row_ideal_mvcc.h"
 #include "row_tcm.h"
+#include "row_silo.h"
+#include "row_calvin.h"
 #include "manager.h"
 #include "workload.h"
 #include "index_hash.h"
@@ -3,6 +3,8 @@
 #include "row_tictoc.h"
 #include "manager.h"
 #include "workload.h"
+#include "message.h"
+#include "packetize.h"
 
 #if CC_ALG == TICTOC
 
@@ -21,6 +23,19 @@ CacheManager::CacheManager()
     }
     _last_output_time = get_sys_clock();
     pthread_mutex_init( &_latch, NULL );
+#if CACHE_ADMISSION
+    // about one counter per cached tuple.
+    uint64_t width = 1024;
+    while (width < _max_cache_size / MAX_TUPLE_SIZE)
+        width *= 2;
+    _sketch = new Sketch(width);
+#endif
+#if CACHE_PUSH
+    assert(g_num_nodes <= 64);
+    _pushes = new vector<Push> * [g_num_worker_threads];
+    for (uint32_t i = 0; i < g_num_worker_threads; i++)
+        _pushes[i] = new vector<Push> [g_num_nodes];
+#endif
 
     _num_vote_local = 0;
     _num_vote_remote = 0;
@@ -60,8 +75,12 @@ CacheManager::lookup(uint64_t key, char * data, uint64_t &wts, uint64_t &rts,
 
     uint32_t bank_id = key_to_bank(key);
     Bank * bank = &_banks[bank_id];
+#if CACHE_ADMISSION
+    _sketch->record(key);
+#endif
 
     bool readonly = false;
+    // a hit only sets the reference bit of the node and does not latch the bank.
     bool cached = _table[bucket_id].read_data(key, data, wts, rts, readonly, bank);
 
     if (cached) {
@@ -75,6 +94,12 @@ CacheManager::lookup(uint64_t key, char * data, uint64_t &wts, uint64_t &rts,
         if (commit_ts <= rts)
             read_cached_value = true;
     #endif
+#endif
+#if CACHE_PUSH
+        // the home node pushes the extensions, so a lease that covers the txn is
+        // likely to still be valid at commit.
+        if (commit_ts <= rts)
+            read_cached_value = true;
 #endif
         INC_INT_STATS(num_cache_hits, 1);
     } else
@@ -92,25 +117,13 @@ CacheManager::lookup(uint64_t key, char * data, uint64_t &wts, uint64_t &rts,
 }
 
 void
-CacheManager::update(uint64_t key, uint64_t rts)
+CacheManager::update(uint64_t key, uint64_t wts, uint64_t rts)
 {
     if (_table_size == 0)
         return;
     uint64_t tt = get_sys_clock();
     uint64_t bucket_id = key_to_bucket(key);
-    uint32_t bank_id = key_to_bank(key);
-    Bank * bank = &_banks[bank_id];
-    bank->latch();
-    Node * node = _table[bucket_id].update(key, rts);
-    if (node) {
-        if (rts > node->row->manager->_rts) {
-            bank->pq.erase(node);
-            node->row->manager->_rts = rts;
-            node->last_access_time = get_sys_clock();
-            bank->pq.insert(node);
-        }
-    }
-    bank->unlatch();
+    _table[bucket_id].update(key, wts, rts);
     INC_FLOAT_STATS(cache, get_sys_clock() - tt);
 }
 
@@ -138,11 +151,20 @@ CacheManager::update_or_insert(uint64_t key, char * data, uint64_t wts, uint64_t
     uint32_t bank_id = key_to_bank(key);
     Bank * bank = &_banks[bank_id];
     bank->latch();
+#if CACHE_ADMISSION
+    // the keys of a bank are only inserted with the bank latch held, so the key
+    // cannot be inserted by others after the check.
+    if (!_table[bucket_id].contains(key) && !admit(bank, key)) {
+        bank->unlatch();
+        INC_FLOAT_STATS(cache, get_sys_clock() - tt);
+        return;
+    }
+#endif
 
     _table[bucket_id].update_or_insert(key, data, wts, rts, false, bank);
     // Cache overflow
     if (bank->cur_size > CacheManager::max_size_per_bank) {
-        Node * node = bank->remove_front();
+        Node * node = bank->evict();
         _table[key_to_bucket(node->key)].remove_data(node->key);
         INC_INT_STATS(num_cache_evictions, 1)
         delete node;
@@ -173,6 +195,100 @@ CacheManager::remove(uint64_t key)
 
 
 
+#if CACHE_PUSH
+void
+CacheManager::invalidate(uint64_t key, uint64_t wts)
+{
+    if (_table_size == 0)
+        return;
+    uint64_t bucket_id = key_to_bucket(key);
+    Bank * bank = &_banks[key_to_bank(key)];
+    bank->latch();
+    // a newer version may have been cached before the push arrives.
+    Node * node = _table[bucket_id].remove_data(key, wts);
+    if (node) {
+        INC_INT_STATS(num_cache_invalidations, 1);
+        bank->remove(node);
+        delete node;
+    }
+    bank->unlatch();
+}
+
+void
+CacheManager::push(uint64_t sharers, uint64_t key, uint64_t wts, uint64_t rts)
+{
+    vector<Push> * pushes = _pushes[GET_THD_ID];
+    for (uint32_t node_id = 0; node_id < g_num_nodes; node_id ++)
+        if (sharers & (1UL << node_id))
+            pushes[node_id].push_back(Push{key, wts, rts});
+}
+
+void
+CacheManager::send_pushes()
+{
+    vector<Push> * pushes = _pushes[GET_THD_ID];
+    for (uint32_t node_id = 0; node_id < g_num_nodes; node_id ++) {
+        if (pushes[node_id].empty())
+            continue;
+        UnstructuredBuffer buffer;
+        uint32_t n = pushes[node_id].size();
+        buffer.put( &n );
+        for (auto &p : pushes[node_id]) {
+            buffer.put( &p.key );
+            buffer.put( &p.wts );
+            buffer.put( &p.rts );
+        }
+        pushes[node_id].clear();
+        uint32_t size = buffer.size();
+        char * data = new char [size];
+        memcpy(data, buffer.data(), size);
+        // the pushes do not belong to any txn.
+        Message * msg = new Message(Message::LOCAL_COPY_RESP, node_id, 0, size, data);
+        while (!output_queues[GET_THD_ID]->push((uint64_t)msg)) {
+            PAUSE10
+        }
+    }
+}
+
+void
+CacheManager::process_pushes(uint32_t size, char * data)
+{
+    UnstructuredBuffer buffer(data);
+    uint32_t n;
+    buffer.get( &n );
+    for (uint32_t i = 0; i < n; i ++) {
+        uint64_t key, wts, rts;
+        buffer.get( &key );
+        buffer.get( &wts );
+        buffer.get( &rts );
+        if (rts == 0)
+            invalidate(key, wts);
+        else {
+            INC_INT_STATS(num_cache_extensions, 1);
+            update(key, wts, rts);
+        }
+    }
+}
+#endif
+
+#if CACHE_ADMISSION
+bool
+CacheManager::admit(Bank * bank, uint64_t key)
+{
+    // the cached tuples all have the same size (see Bucket::update_or_insert).
+    if (!bank->hand || bank->cur_size + bank->hand->row->get_tuple_size()
+                       <= CacheManager::max_size_per_bank)
+        return true;
+    Node * victim = bank->victim();
+    if (_sketch->estimate(key) > _sketch->estimate(victim->key)) {
+        INC_INT_STATS(num_cache_admits, 1);
+        return true;
+    }
+    INC_INT_STATS(num_cache_rejects, 1);
+    return false;
+}
+#endif
+
 void
 CacheManager::update_table_lease(uint32_t table_id, uint64_t wts, uint64_t rts)
 {
@@ -214,18 +330,25 @@ CacheManager::Bucket::read_data(uint64_t key, char * data, uint64_t &wts, uint64
         memcpy(data, node->row->get_data(), node->row->get_tuple_size());
         wts = node->row->manager->get_wts();
         rts = node->row->manager->get_rts();
+        node->ref = true;
     }
     release_latch();
     return node != NULL;
 }
 
 CacheManager::Node *
-CacheManager::Bucket::update(uint64_t key, uint64_t rts)
+CacheManager::Bucket::update(uint64_t key, uint64_t wts, uint64_t rts)
 {
+    // the bucket latch keeps the node from being evicted and freed.
     get_latch();
     Node * node = _first_node;
     while (node && node->key != key)
         node = node->next;
+    if (node && node->row->manager->get_wts() == wts
+        && rts > node->row->manager->get_rts()) {
+        node->row->manager->update_rts(rts);
+        node->ref = true;
+    }
     release_latch();
     return node;
 }
@@ -255,9 +378,7 @@ CacheManager::Bucket::update_or_insert(uint64_t key, char * data, uint64_t wts,
         // update
         INC_INT_STATS(num_cache_updates, 1);
         node->row->manager->update(data, wts, rts);
-        bank->pq.erase(node);
-        node->last_access_time = get_sys_clock();
-        bank->pq.insert(node);
+        node->ref = true;
         release_latch();
         return node;
     } else {
@@ -281,8 +402,19 @@ CacheManager::Bucket::update_or_insert(uint64_t key, char * data, uint64_t wts,
     }
 }
 
+bool
+CacheManager::Bucket::contains(uint64_t key)
+{
+    get_latch();
+    Node * node = _first_node;
+    while (node && node->key != key)
+        node = node->next;
+    release_latch();
+    return node != NULL;
+}
+
 CacheManager::Node *
-CacheManager::Bucket::remove_data(uint64_t key)
+CacheManager::Bucket::remove_data(uint64_t key, uint64_t max_wts)
 {
     get_latch();
     Node * prev = NULL;
@@ -291,6 +423,8 @@ CacheManager::Bucket::remove_data(uint64_t key)
         prev = node;
         node = node->next;
     }
+    if (node && node->row->manager->get_wts() >= max_wts)
+        node = NULL;
     if (node) {
         if (!prev)
             _first_node = _first_node->next;
@@ -326,16 +460,11 @@ CacheManager::Node::~Node()
 /////////////////////////////////////
 CacheManager::Bank::Bank()
 {
+    hand = NULL;
     cur_size = 0;
     pthread_mutex_init( &_latch, NULL );
 }
 
-bool
-CacheManager::Bank::Compare::operator() (const Node * left, const Node * right) const
-{
-    return left->last_access_time < right->last_access_time;
-}
-
 void
 CacheManager::Bank::latch()
 {
@@ -348,34 +477,111 @@ CacheManager::Bank::unlatch()
     pthread_mutex_unlock( &_latch );
 }
 
-CacheManager::Node *
+void
 CacheManager::Bank::insert(Node * node)
 {
-    node->last_access_time = get_sys_clock();
-    auto ret = pq.insert(node);
-    assert(ret.second);
+    assert(!node->clock_next);
+    // insert right behind the hand, so the new node is swept last.
+    if (!hand) {
+        node->clock_prev = node;
+        node->clock_next = node;
+        hand = node;
+    } else {
+        node->clock_prev = hand->clock_prev;
+        node->clock_next = hand;
+        hand->clock_prev->clock_next = node;
+        hand->clock_prev = node;
+    }
     cur_size += node->row->get_tuple_size();
-    return NULL;
 }
 
 void
 CacheManager::Bank::remove(Node * node)
 {
-    int n = pq.erase(node);
-    M_ASSERT(n > 0, "n=%d\n", n);
+    assert(node->clock_next);
+    if (node->clock_next == node) {
+        assert(hand == node);
+        hand = NULL;
+    } else {
+        node->clock_prev->clock_next = node->clock_next;
+        node->clock_next->clock_prev = node->clock_prev;
+        if (hand == node)
+            hand = node->clock_next;
+    }
+    node->clock_prev = NULL;
+    node->clock_next = NULL;
     cur_size -= node->row->get_tuple_size();
 }
 
 CacheManager::Node *
-CacheManager::Bank::remove_front()
+CacheManager::Bank::victim()
 {
-    set<Node *>::iterator it = pq.begin();
-    Node * node = *it;
-    cur_size -= node->row->get_tuple_size();
-    pq.erase( it );
+    assert(hand);
+    while (hand->ref) {
+        hand->ref = false;
+        hand = hand->clock_next;
+    }
+    return hand;
+}
+
+CacheManager::Node *
+CacheManager::Bank::evict()
+{
+    Node * node = victim();
+    remove(node);
     return node;
 }
 
+#if CACHE_ADMISSION
+/////////////////////////////////////
+// Sketch
+/////////////////////////////////////
+CacheManager::Sketch::Sketch(uint64_t width)
+{
+    assert((width & (width - 1)) == 0);
+    _width = width;
+    _sample_size = 10 * width;
+    _num_samples = 0;
+    _counters = new uint8_t [DEPTH * width];
+    memset(_counters, 0, DEPTH * width);
+}
+
+uint64_t
+CacheManager::Sketch::index(uint64_t key, uint32_t row)
+{
+    uint64_t h = key * 0x9e3779b97f4a7c15UL;
+    h ^= h >> 31;
+    // double hashing. The step is odd so the rows differ.
+    return row * _width + ((h + row * ((h >> 32) | 1)) & (_width - 1));
+}
+
+void
+CacheManager::Sketch::record(uint64_t key)
+{
+    // NOTE. the counters are not updated atomically. Losing an update is OK since
+    // the sketch is an approximate.
+    for (uint32_t row = 0; row < DEPTH; row ++) {
+        uint8_t &counter = _counters[index(key, row)];
+        if (counter < UINT8_MAX)
+            counter ++;
+    }
+    if (ATOM_ADD_FETCH(_num_samples, 1) == _sample_size) {
+        for (uint64_t i = 0; i < DEPTH * _width; i ++)
+            _counters[i] /= 2;
+        _num_samples = 0;
+    }
+}
+
+uint32_t
+CacheManager::Sketch::estimate(uint64_t key)
+{
+    uint32_t freq = UINT8_MAX;
+    for (uint32_t row = 0; row < DEPTH; row ++)
+        freq = min(freq, (uint32_t)_counters[index(key, row)]);
+    return freq;
+}
+#endif
+
 void
 CacheManager::vote_local()
 {
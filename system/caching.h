@@ -6,7 +6,9 @@
 
 // The cache manager maintains the locally cached data in Sundial.
 // The structure is partitioned into multiple banks.
-// Each bank independently manages information like LRU, occupancy, etc.
+// Each bank independently manages information like replacement, occupancy, etc.
+// Replacement is CLOCK: an access sets the reference bit of a node without the bank
+// latch, and the clock hand of the bank clears the bits as it sweeps for a victim.
 class row_t;
 
 class CacheManager {
@@ -17,7 +19,8 @@ public:
     // TODO. implement cache replacement
     bool lookup(uint64_t key, char * data, uint64_t &wts, uint64_t &rts,
                 bool &read_cached_value, uint64_t commit_ts);
-    void update(uint64_t key, uint64_t rts);
+    // extend the rts of the cached version wts.
+    void update(uint64_t key, uint64_t wts, uint64_t rts);
     void update_data(uint64_t key, uint64_t cts, char * data);
     void update_or_insert(uint64_t key, char * data, uint64_t wts, uint64_t rts);//, bool readonly);
     void remove(uint64_t key);
@@ -34,6 +37,18 @@ public:
 
     void vote_local();
     void vote_remote();
+
+#if CACHE_PUSH
+    // [home node] push to the nodes in sharers (one bit per node) that version wts
+    // of key is replaced (rts == 0) or extended to rts. The pushes are batched per
+    // worker thread and destination node.
+    void push(uint64_t sharers, uint64_t key, uint64_t wts, uint64_t rts);
+    // send the batched pushes of the worker thread in LOCAL_COPY_RESP messages.
+    void send_pushes();
+    // [caching node] apply the pushes from a home node.
+    //    | n | (key, wts, rts) * n |
+    void process_pushes(uint32_t size, char * data);
+#endif
 private:
     class Node;
     class Bank {
@@ -41,19 +56,17 @@ private:
         Bank();
         void latch();
         void unlatch();
-        // return value: exivted node.
-        // TODO. assuem only one node is evicted.
-        Node * insert(Node * node);
+        // the following functions are called with the bank latch held.
+        void insert(Node * node);
         void remove(Node * node);
-        Node * remove_front();
+        // sweep the clock hand to the first node not referenced since the last sweep.
+        Node * victim();
+        // remove the victim.
+        Node * evict();
 
-        class Compare
-        {
-        public:
-            bool operator() (const Node * left, const Node * right) const;
-        };
         pthread_mutex_t _latch;
-        set<Node *, Compare> pq;
+        // the nodes of the bank form a circular list. NULL if the bank is empty.
+        Node * hand;
         uint64_t cur_size;
     };
 
@@ -63,6 +76,9 @@ private:
             this->key = key;
             next = NULL;
             row = NULL;
+            ref = false;
+            clock_prev = NULL;
+            clock_next = NULL;
         }
         ~Node();
         // the tuple is predicted to be readonly
@@ -70,21 +86,26 @@ private:
         uint64_t    key;
         Node *         next;
         row_t *     row;
-        uint64_t    last_access_time;
+        // CLOCK reference bit. Set on access without latching.
+        volatile bool ref;
+        Node *         clock_prev;
+        Node *         clock_next;
     };
 
     class Bucket {
     public:
         Bucket();
         void init();
-        Node * update(uint64_t key, uint64_t rts);
+        Node * update(uint64_t key, uint64_t wts, uint64_t rts);
         void update_data(uint64_t key, uint64_t cts, char * data);
         bool read_data(uint64_t key, char * data, uint64_t &wts, uint64_t &rts,
                                 bool &readonly, Bank * bank);
         // return value: size of inserted/removed data.
         Node * update_or_insert(uint64_t key, char * data, uint64_t wts, uint64_t rts,
                                 bool readonly, Bank * bank);
-        Node * remove_data(uint64_t key);
+        // remove the node if its wts is below max_wts.
+        Node * remove_data(uint64_t key, uint64_t max_wts = UINT64_MAX);
+        bool contains(uint64_t key);
     private:
         void get_latch();
         void release_latch();
@@ -107,6 +128,37 @@ private:
     uint64_t     _num_banks;
     Bank *         _banks;
 
+#if CACHE_ADMISSION
+    // TinyLFU. A count-min sketch estimates the access frequency of the keys.
+    // All counters are halved every 10 * width accesses, so old accesses fade.
+    class Sketch {
+    public:
+        Sketch(uint64_t width);
+        void         record(uint64_t key);
+        uint32_t     estimate(uint64_t key);
+    private:
+        static const uint32_t DEPTH = 4;
+        uint64_t     index(uint64_t key, uint32_t row);
+        uint8_t *     _counters;
+        uint64_t     _width;
+        uint64_t     _sample_size;
+        uint64_t     _num_samples;
+    };
+    Sketch *     _sketch;
+    // whether key should be inserted into the bank. Called with the bank latch held.
+    bool         admit(Bank * bank, uint64_t key);
+#endif
+#if CACHE_PUSH
+    struct Push {
+        uint64_t key;
+        uint64_t wts;
+        uint64_t rts;
+    };
+    // _pushes[thd_id][node_id]. Only accessed by the worker thread.
+    vector<Push> ** _pushes;
+    void         invalidate(uint64_t key, uint64_t wts);
+#endif
+
     pthread_mutex_t _latch;
     // _table_lease is deprecated. Should remove.
     map<uint32_t, pair<uint64_t, uint64_t>> _table_lease;
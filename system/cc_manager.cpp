@@ -7,6 +7,9 @@
 #include "maat_manager.h"
 #include "ideal_mvcc_manager.h"
 #include "tcm_manager.h"
+#include "silo_manager.h"
+#include "calvin_manager.h"
+#include "row_lock.h"
 #include "index_btree.h"
 #include "index_hash.h"
 #include "manager.h"
@@ -110,3 +113,32 @@ CCManager::commit_insdel()
     assert(false);
     return RCOK;
 }
+
+RC
+CCManager::add_increment(row_t * row, Catalog * schema, uint32_t col, double delta,
+                         double min, double max)
+{
+#if INC_SUPPORTED
+    Increment inc;
+    inc.row = row;
+    inc.field = row_t::get_value(schema, col, row->get_data());
+    inc.delta = delta;
+    if (row->manager->escrow_reserve(inc.field, delta, min, max) == ABORT)
+        return ABORT;
+    _increments.push_back(inc);
+    return RCOK;
+#else
+    assert(false);
+    return ABORT;
+#endif
+}
+
+void
+CCManager::apply_increments(RC rc)
+{
+#if INC_SUPPORTED
+    for (auto &inc : _increments)
+        inc.row->manager->escrow_release(inc.field, inc.delta, rc == COMMIT);
+#endif
+    _increments.clear();
+}
@@ -11,6 +11,7 @@ class StoreProcedure;
 class UnstructuredBuffer;
 class RemoteQuery;
 class itemid_t;
+class Catalog;
 
 class CCManager
 {
@@ -34,6 +35,11 @@ public:
     virtual RC         get_row(row_t * row, access_t type, uint64_t key) { assert(false); }
     virtual RC         get_row(row_t * row, access_t type, char * &data, uint64_t key) = 0;
 
+    // For INC accesses. The delta is reserved in the escrow of the tuple and added to
+    // the column at commit. Returns ABORT if the column could leave [min, max].
+    RC               add_increment(row_t * row, Catalog * schema, uint32_t col, double delta,
+                                   double min, double max);
+
     virtual char *     get_data(uint64_t key, uint32_t table_id) { assert(false); }
     virtual char *     get_data(uint32_t table_id) { assert(false); }
     virtual char *     get_last_data() { assert(false); }
@@ -69,6 +75,12 @@ public:
     virtual void     get_resp_data(uint32_t &size, char * &data) { assert(false); }
     virtual void     process_remote_resp(uint32_t node_id, uint32_t size, char * resp_data) {};
 
+    // lock phase. Only for NAIVE_TICTOC and SILO, which lock the write set before 2PC.
+    virtual RC         process_lock_phase_coord() { assert(false); }
+    virtual RC         process_lock_req(uint32_t size, char * data, uint32_t &resp_size, char * &resp_data)
+                    { assert(false); }
+    virtual void     process_lock_resp(RC rc, uint32_t node_id, char * data) { assert(false); }
+
     // prepare phase.
     // return value: whether a prepare message needs to be sent
     virtual void     get_remote_nodes(set<uint32_t> * _remote_nodes) {};
@@ -135,6 +147,15 @@ protected:
         set<row_t *> * rows;
     };
 
+    // apply the increments if the txn commits, release their reservations and clear them.
+    void             apply_increments(RC rc);
+    struct Increment {
+        row_t *     row;
+        char *     field;
+        double     delta;
+    };
+    vector<Increment> _increments;
+
     TxnManager *         _txn;
     struct InsertOp {
         table_t * table;
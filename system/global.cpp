@@ -20,11 +20,22 @@ carbon_barrier_t enable_barrier;
 #if ENABLE_LOCAL_CACHING
 CacheManager * local_cache_man;
 #endif
+#if CC_ALG == DL_DETECT
+DL_detect * dl_detector;
+#endif
+#if CC_ALG == CALVIN
+Sequencer * sequencer;
+#endif
+#if ADAPTIVE_BACKOFF
+RetryScheduler * retry_scheduler;
+#endif
 
 ////////////////////////////
 // Global Parameter
 ////////////////////////////
 uint64_t g_abort_penalty     = ABORT_PENALTY;
+uint64_t g_max_abort_penalty = MAX_ABORT_PENALTY;
+uint32_t g_hot_key_aborts    = HOT_KEY_ABORTS;
 uint32_t g_ts_alloc         = TS_ALLOC;
 bool g_key_order             = KEY_ORDER;
 bool g_ts_batch_alloc         = TS_BATCH_ALLOC;
@@ -76,6 +87,15 @@ uint32_t g_cust_per_dist = 3000;
 char * output_file = NULL;
 char ifconfig_file[80] = "ifconfig.txt";
 
+// DL_DETECT
+uint64_t g_dl_detect_interval = DL_DETECT_INTERVAL;
+
+// SILO
+uint64_t g_silo_epoch_interval = SILO_EPOCH_INTERVAL;
+
+// CALVIN
+uint64_t g_calvin_epoch_interval = CALVIN_EPOCH_INTERVAL;
+
 // TICTOC
 uint32_t g_max_num_waits = MAX_NUM_WAITS;
 uint64_t g_local_cache_size = LOCAL_CACHE_SIZE;
@@ -99,6 +119,13 @@ bool g_is_client_node = false;
 
 uint32_t g_num_input_threads = NUM_INPUT_THREADS;
 uint32_t g_num_output_threads = NUM_OUTPUT_THREADS;
+bool g_recv_busy_poll = RECV_BUSY_POLL;
+uint32_t g_transport_type = TRANSPORT_TYPE;
+uint32_t g_inout_queue_size = INOUT_QUEUE_SIZE;
+uint64_t g_net_emu_delay = NET_EMU_DELAY;
+uint64_t g_net_emu_jitter = NET_EMU_JITTER;
+uint64_t g_net_emu_bandwidth = NET_EMU_BANDWIDTH;
+char net_emu_file[80] = "";
 
 Transport ** transport;
 InOutQueue ** input_queues;
@@ -21,10 +21,11 @@
 #include <time.h>
 #include <sys/time.h>
 #include <math.h>
-#include <boost/lockfree/queue.hpp>
+#include <algorithm>
 #include "pthread.h"
 
 #include "config.h"
+#include "spsc_queue.h"
 #include "stats.h"
 #ifndef NOGRAPHITE
 #include "carbon_user.h"
@@ -34,6 +35,8 @@ using namespace std;
 
 class Stats;
 class DL_detect;
+class Sequencer;
+class RetryScheduler;
 class Manager;
 class Query_queue;
 class Plock;
@@ -71,6 +74,15 @@ extern carbon_barrier_t enable_barrier;
 #if ENABLE_LOCAL_CACHING
 extern CacheManager * local_cache_man;
 #endif
+#if CC_ALG == DL_DETECT
+extern DL_detect * dl_detector;
+#endif
+#if CC_ALG == CALVIN
+extern Sequencer * sequencer;
+#endif
+#if ADAPTIVE_BACKOFF
+extern RetryScheduler * retry_scheduler;
+#endif
 
 /******************************************/
 // Global Parameter
@@ -82,6 +94,8 @@ extern uint32_t g_num_server_threads;
 
 extern uint32_t g_total_num_threads;
 extern ts_t g_abort_penalty;
+extern uint64_t g_max_abort_penalty;
+extern uint32_t g_hot_key_aborts;
 extern uint32_t g_ts_alloc;
 extern bool g_key_order;
 extern bool g_ts_batch_alloc;
@@ -91,6 +105,15 @@ extern double g_warmup_time;
 extern double g_run_time;
 extern uint64_t g_max_clock_skew;
 
+// DL_DETECT
+extern uint64_t g_dl_detect_interval;
+
+// SILO
+extern uint64_t g_silo_epoch_interval;
+
+// CALVIN
+extern uint64_t g_calvin_epoch_interval;
+
 // TICTOC
 extern uint32_t g_max_num_waits;
 extern uint64_t g_local_cache_size;
@@ -138,7 +161,11 @@ enum latch_t {LATCH_EX, LATCH_SH, LATCH_NONE};
 enum idx_acc_t {INDEX_INSERT, INDEX_READ, INDEX_NONE};
 
 // LOOKUP, INS and DEL are operations on indexes.
-enum access_t {RD, WR, XP, SCAN, INS, DEL};
+// INC adds to numeric columns of a tuple. It commutes with other INCs but not with RD or WR.
+enum access_t {RD, WR, XP, SCAN, INS, DEL, INC};
+// INC accesses are only supported by 2PL; the other algorithms use WR instead.
+#define INC_SUPPORTED (COMMUTATIVE_INC && (CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT \
+    || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT))
 
 // TIMESTAMP
 enum TsType {R_REQ, W_REQ, P_REQ, XP_REQ};
@@ -155,7 +182,7 @@ enum Isolation {SR, SI, RR, NO_ACID};
 #define INDEX        IndexHash
 #endif
 
-#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT
+#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
     class Row_lock;
     class LockManager;
     #define ROW_MAN Row_lock
@@ -190,6 +217,16 @@ enum Isolation {SR, SI, RR, NO_ACID};
     class TCMManager;
     #define ROW_MAN Row_TCM
     #define CC_MAN TCMManager
+#elif CC_ALG == SILO
+    class Row_silo;
+    class SiloManager;
+    #define ROW_MAN Row_silo
+    #define CC_MAN SiloManager
+#elif CC_ALG == CALVIN
+    class Row_calvin;
+    class CalvinManager;
+    #define ROW_MAN Row_calvin
+    #define CC_MAN CalvinManager
 #endif
 /************************************************/
 // constants
@@ -207,9 +244,18 @@ extern uint32_t g_node_id;
 
 extern uint32_t g_num_input_threads;
 extern uint32_t g_num_output_threads;
+extern bool g_recv_busy_poll;
+extern uint32_t g_transport_type;
+extern uint32_t g_inout_queue_size;
+extern uint64_t g_net_emu_delay;
+extern uint64_t g_net_emu_jitter;
+extern uint64_t g_net_emu_bandwidth;
+extern char net_emu_file[];
 
 extern Transport ** transport;
-typedef boost::lockfree::queue<uint64_t, boost::lockfree::capacity<INOUT_QUEUE_SIZE>> InOutQueue;
+// input_queues[i] is written by one input thread and read by worker i.
+// output_queues[i] is written by worker i and read by one output thread.
+typedef SpscQueue InOutQueue;
 extern InOutQueue ** input_queues;
 extern InOutQueue ** output_queues;
 extern ServerThread ** server_threads;
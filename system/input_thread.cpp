@@ -6,6 +6,9 @@
 #include "workload.h"
 #include "manager.h"
 #include "server_thread.h"
+#include "dl_detect.h"
+#include "sequencer.h"
+#include "caching.h"
 
 InputThread::InputThread(uint64_t thd_id)
     : Thread(thd_id, INPUT_THREAD)
@@ -15,6 +18,13 @@ InputThread::InputThread(uint64_t thd_id)
         _msg_size[i] = 0;
     }
     _transport = transport[thd_id % g_num_input_threads];
+    _batch = new uint64_t * [g_num_worker_threads];
+    _batch_size = new uint32_t [g_num_worker_threads];
+    for (uint32_t i = 0; i < g_num_worker_threads; i++) {
+        _batch[i] = (i % g_num_input_threads == thd_id % g_num_input_threads)?
+            new uint64_t [INPUT_DEMUX_BATCH] : NULL;
+        _batch_size[i] = 0;
+    }
 }
 
 void InputThread::dealwithMsg(Message * msg, uint64_t t1)
@@ -43,6 +53,21 @@ void InputThread::dealwithMsg(Message * msg, uint64_t t1)
             num_termination_received ++;
             if (num_termination_received == g_num_server_nodes - 1)
                 glob_manager->set_remote_done();
+#if CC_ALG == DL_DETECT
+        } else if (msg->get_type() == Message::DL_EDGES) {
+            dl_detector->set_remote_edges(msg->get_src_node_id(), msg->get_data_size(), msg->get_data());
+            DELETE(Message, msg);
+#endif
+#if CC_ALG == CALVIN
+        } else if (msg->get_type() == Message::CALVIN_BATCH) {
+            sequencer->add_batch(msg->get_src_node_id(), msg->get_data_size(), msg->get_data());
+            DELETE(Message, msg);
+#endif
+#if CC_ALG == TICTOC && CACHE_PUSH
+        } else if (msg->get_type() == Message::LOCAL_COPY_RESP) {
+            local_cache_man->process_pushes(msg->get_data_size(), msg->get_data());
+            DELETE(Message, msg);
+#endif
         } else {
             uint32_t queue_id = 0;
             queue_id = glob_manager->txnid_to_server_thread(msg->get_txn_id());
@@ -50,17 +75,14 @@ void InputThread::dealwithMsg(Message * msg, uint64_t t1)
             M_ASSERT(queue_id % g_num_input_threads == GET_THD_ID % g_num_input_threads,
                     "queue_id=%d, thd_id=%ld\n", queue_id, GET_THD_ID);
 
-            uint64_t tt = get_sys_clock();
-            bool success = input_queues[ queue_id ]->push((uint64_t)msg);
-            while (!success) {
-                PAUSE
-                success = input_queues[ queue_id ]->push((uint64_t)msg);
-            }
-            INC_FLOAT_STATS(time_debug7, get_sys_clock() - tt);
+            assert(_batch_size[queue_id] < INPUT_DEMUX_BATCH);
+            _batch[queue_id][ _batch_size[queue_id] ++ ] = (uint64_t)msg;
         }
         INC_FLOAT_STATS(time_write_queue, get_sys_clock() - t2);
     } else {
-        PAUSE10
+        // without busy polling, recvMsg() already blocked in epoll_wait.
+        if (g_recv_busy_poll)
+            PAUSE10
         INC_FLOAT_STATS(time_input_idle, get_sys_clock() - t1);
     }
 }
@@ -87,11 +109,45 @@ InputThread::run()
     {
         uint64_t t1 = get_sys_clock();
         msg = _transport->recvMsg();
-        dealwithMsg(msg, t1);
+        if (msg == NULL) {
+            dealwithMsg(msg, t1);
+            continue;
+        }
+        // take everything that is already received (without waiting), then
+        // publish it to the workers.
+        uint32_t num_msgs = 0;
+        while (msg) {
+            dealwithMsg(msg, t1);
+            if (++ num_msgs == INPUT_DEMUX_BATCH)
+                break;
+            t1 = get_sys_clock();
+            msg = _transport->recvMsg(false);
+        }
+        flush_input_queues();
     }
     return RCOK;
 }
 
+void
+InputThread::flush_input_queues()
+{
+    uint64_t t1 = get_sys_clock();
+    // called from global_sync() too, before the thread id is registered.
+    for (uint32_t queue_id = get_thd_id() % g_num_input_threads; queue_id < g_num_worker_threads;
+         queue_id += g_num_input_threads)
+    {
+        uint32_t size = _batch_size[queue_id];
+        uint32_t pushed = 0;
+        while (pushed < size) {
+            pushed += input_queues[queue_id]->push_batch(_batch[queue_id] + pushed, size - pushed);
+            if (pushed < size)
+                PAUSE
+        }
+        _batch_size[queue_id] = 0;
+    }
+    INC_FLOAT_STATS(time_write_queue, get_sys_clock() - t1);
+}
+
 void
 InputThread::global_sync()
 {
@@ -100,10 +156,14 @@ InputThread::global_sync()
     while (num_msg_received < g_num_nodes - 1) {
         uint64_t t1 = get_sys_clock();
         Message * msg = _transport->recvMsg();
-        if (msg && msg->get_txn_id() == 0) {  // I assume that everyone will not send any other messages after they send their single msg whose txn_id=0
+        // other txn-less messages (e.g., CALVIN_BATCH, DL_EDGES) may arrive before
+        // the TERMINATE of a slower node.
+        if (msg && msg->get_type() == Message::TERMINATE) {
             num_msg_received ++;
-        } else
+        } else {
             dealwithMsg(msg, t1);
+            flush_input_queues();
+        }
         PAUSE;
     }
 }
@@ -118,6 +178,6 @@ InputThread::measure_bw()
     do{
         msg = _transport->recvMsg();
         if (msg)
-            FREE(msg, sizeof(Message));
+            delete msg;
     } while (!msg || msg->get_type() != Message::TERMINATE);
 }
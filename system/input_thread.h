@@ -6,6 +6,9 @@
 
 class Transport;
 
+// max number of messages received before they are published to the workers.
+#define INPUT_DEMUX_BATCH 64
+
 class InputThread : public Thread
 {
 public:
@@ -18,6 +21,12 @@ private:
     void global_sync();
     void measure_bw();
     void dealwithMsg(Message * msg, uint64_t t1);
+    // push the staged messages of each worker with one batched enqueue.
+    void flush_input_queues();
+
+    // messages staged for each worker thread, indexed by queue id.
+    uint64_t ** _batch;
+    uint32_t *  _batch_size;
 
     uint64_t _msg_count[Message::NUM_MSG_TYPES];
     uint64_t _msg_size[Message::NUM_MSG_TYPES];
@@ -7,12 +7,18 @@
 #include "query.h"
 #include "transport.h"
 #include "txn_table.h"
+#include "dl_detect.h"
+#include "sequencer.h"
+#include "retry_scheduler.h"
 #include "input_thread.h"
 #include "output_thread.h"
 #include "caching.h"
 #include "log.h"
 
 void * start_thread(void *);
+#if CC_ALG == SILO
+void * run_epoch_thread(void *);
+#endif
 
 InputThread ** input_threads;
 OutputThread ** output_threads;
@@ -26,11 +32,15 @@ int main(int argc, char* argv[])
     M_ASSERT(INDEX_STRUCT != IDX_BTREE, "btree is not supported yet\n");
     transport = new Transport * [g_num_input_threads];
     for (uint32_t i = 0; i < g_num_input_threads; i ++)
-        transport[i] = new Transport(i);
+        transport[i] = Transport::create(i);
 
     // g_num_worker_threads is the # of server threads running on each node
     g_num_worker_threads = g_num_server_threads;
 
+    // the messages of the connection test already carry the clock of TS_HLC.
+    glob_manager = (Manager *) _mm_malloc(sizeof(Manager), 64);
+    glob_manager->init();
+
     for (uint32_t i = 0; i < g_num_input_threads; i ++)
         transport[i]->test_connect();
 
@@ -40,9 +50,9 @@ int main(int argc, char* argv[])
     output_queues = new InOutQueue * [g_num_worker_threads];
     for (uint32_t i = 0; i < g_num_worker_threads; i++) {
         input_queues[i] = (InOutQueue *) _mm_malloc(sizeof(InOutQueue), 64);
-        new (input_queues[i]) InOutQueue;
+        new (input_queues[i]) InOutQueue(g_inout_queue_size);
         output_queues[i] = (InOutQueue *) _mm_malloc(sizeof(InOutQueue), 64);
-        new (output_queues[i]) InOutQueue;
+        new (output_queues[i]) InOutQueue(g_inout_queue_size);
     }
   #if CC_ALG == TICTOC && ENABLE_LOCAL_CACHING
     local_cache_man = new CacheManager;
@@ -51,9 +61,16 @@ int main(int argc, char* argv[])
     stats = (Stats *) _mm_malloc(sizeof(Stats), 64);
     new(stats) Stats();
 
-    glob_manager = (Manager *) _mm_malloc(sizeof(Manager), 64);
-    glob_manager->init();
     txn_table = new TxnTable();
+#if CC_ALG == DL_DETECT
+    dl_detector = new DL_detect;
+#endif
+#if CC_ALG == CALVIN
+    sequencer = new Sequencer;
+#endif
+#if ADAPTIVE_BACKOFF
+    retry_scheduler = new RetryScheduler;
+#endif
     log_manager = new LogManager();
 
     printf("mem_allocator initialized!\n");
@@ -104,12 +121,21 @@ int main(int argc, char* argv[])
     for (uint64_t i = 0; i < g_num_output_threads; i++)
         pthread_create(&pthreads[g_num_worker_threads + g_num_input_threads + i], NULL, start_thread, (void *)output_threads[i]);
 
+#if CC_ALG == SILO
+    // the epoch thread does not join global_barrier.
+    pthread_t epoch_thread;
+    pthread_create(&epoch_thread, NULL, run_epoch_thread, NULL);
+#endif
+
     start_thread((void *)(worker_threads[g_num_worker_threads - 1]));
 
     for (uint32_t i = 0; i < g_num_worker_threads - 1; i++)
         pthread_join(pthreads[i], NULL);
     for (uint64_t i = 0; i < g_num_input_threads + g_num_output_threads; i++)
         pthread_join(pthreads[g_num_worker_threads + i], NULL);
+#if CC_ALG == SILO
+    pthread_join(epoch_thread, NULL);
+#endif
     clock_gettime(CLOCK_REALTIME, tp);
     uint64_t end_t = tp->tv_sec * 1000000000 + tp->tv_nsec;
 
@@ -133,3 +159,13 @@ void * start_thread(void * thread) {
     thd->run();
     return NULL;
 }
+
+#if CC_ALG == SILO
+void * run_epoch_thread(void *) {
+    while (!glob_manager->is_sim_done()) {
+        usleep(g_silo_epoch_interval * 1000);
+        glob_manager->advance_epoch();
+    }
+    return NULL;
+}
+#endif
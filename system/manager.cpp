@@ -6,6 +6,7 @@
 __thread drand48_data Manager::_buffer;
 __thread uint64_t Manager::_thread_id;
 __thread uint64_t Manager::_max_cts = 1;
+__thread uint64_t Manager::_last_hlc = 0;
 
 void
 Manager::init() {
@@ -42,6 +43,10 @@ Manager::init() {
         _gc_ts_per_node[i] = (uint64_t *) _mm_malloc(sizeof(uint64_t), 64);
         *_gc_ts_per_node[i] = 0;
     }
+    // SILO
+    _epoch = 1;
+    // TS_HLC
+    _max_remote_hlc = 0;
 }
 
 uint64_t
@@ -67,6 +72,9 @@ Manager::get_ts(uint64_t thread_id) {
     case TS_CLOCK :
         time = (get_sys_clock() * g_num_worker_threads + thread_id) * g_num_server_nodes + g_node_id;
         break;
+    case TS_HLC :
+        time = (get_hlc() * g_num_worker_threads + thread_id) * g_num_server_nodes + g_node_id;
+        break;
     default :
         assert(false);
     }
@@ -74,6 +82,29 @@ Manager::get_ts(uint64_t thread_id) {
     return time;
 }
 
+uint64_t
+Manager::get_hlc()
+{
+    uint64_t hlc = get_sys_clock();
+    if (hlc <= _max_remote_hlc)
+        hlc = _max_remote_hlc + 1;
+    if (hlc <= _last_hlc)
+        hlc = _last_hlc + 1;
+    _last_hlc = hlc;
+    return hlc;
+}
+
+void
+Manager::update_hlc(uint64_t hlc)
+{
+    uint64_t old_hlc = _max_remote_hlc;
+    while (hlc > old_hlc) {
+        if (ATOM_CAS(_max_remote_hlc, old_hlc, hlc))
+            break;
+        old_hlc = _max_remote_hlc;
+    }
+}
+
 ts_t Manager::get_min_ts(uint64_t tid) {
     uint64_t now = get_sys_clock();
     uint64_t last_time = _last_min_ts_time;
@@ -163,7 +194,8 @@ Manager::txnid_to_server_thread(uint64_t txn_id)
 uint64_t
 Manager::get_current_time()
 {
-    uint64_t ts = get_sys_clock() * g_num_nodes + g_node_id;
+    uint64_t clock = (g_ts_alloc == TS_HLC)? get_hlc() : get_sys_clock();
+    uint64_t ts = clock * g_num_nodes + g_node_id;
     *_early_per_thread[GET_THD_ID] = ts;
     uint64_t min = (uint64_t)-1;
     for (uint64_t i = 0; i < g_num_worker_threads; i++)
@@ -17,6 +17,12 @@ public:
     // Global timestamp allocation
     uint64_t        get_ts(uint64_t thread_id);
 
+    // TS_HLC. The hybrid clock of the calling thread, which is strictly increasing and
+    // larger than any clock received from a remote node. Lock-free.
+    uint64_t        get_hlc();
+    // advance the node's clock on receiving a message.
+    void            update_hlc(uint64_t hlc);
+
     // For MVCC. To calculate the min active ts in the system
     void             add_ts(uint64_t ts);
     uint64_t         get_min_ts(uint64_t tid = 0);
@@ -60,6 +66,10 @@ public:
     uint64_t         get_gc_ts() { return _global_gc_min_ts; }
     void              set_gc_ts(uint64_t ts);
     void             update_global_gc_ts(uint32_t node_id, uint64_t ts);
+
+    // SILO global epoch, advanced by the epoch thread every SILO_EPOCH_INTERVAL.
+    uint64_t         get_epoch() { return _epoch; }
+    void             advance_epoch() { ATOM_ADD_FETCH(_epoch, 1); }
 private:
     pthread_mutex_t ts_mutex;
     uint64_t *        timestamp;
@@ -81,6 +91,9 @@ private:
     // For TICTOC timestamp
     static __thread uint64_t _max_cts; // max commit timestamp seen by the thread so far.
 
+    // TS_HLC
+    static __thread uint64_t _last_hlc; // last clock returned to the thread.
+
     // thread local transport
     //static __thread Transport * _transport;
 
@@ -97,4 +110,10 @@ private:
     // For TCM GC. Maintain the lowest early timestamp ever seen
     uint64_t **        _early_per_thread;
     uint64_t **     _gc_ts_per_node;
+
+    // SILO
+    ALIGNED(64) volatile uint64_t    _epoch;
+
+    // TS_HLC. The max clock received from the remote nodes.
+    ALIGNED(64) volatile uint64_t    _max_remote_hlc;
 };
@@ -28,16 +28,15 @@ OutputThread::run()
     pthread_barrier_wait( &global_barrier );
 
     Message * msg;
+    uint64_t msg_batch[OUTPUT_QUEUE_BATCH];
     bool sim_done = false;
     // Stats
     uint64_t total_bytes_sent = 0;
-#if ENABLE_MSG_BUFFER
-    uint64_t last_send_time = get_sys_clock();
-#endif
     //Main loop
     uint32_t output_thread_id = GET_THD_ID % g_num_input_threads;
     if (g_num_nodes == 1)
         return RCOK;
+    _transport->startNetEmu();
 #if CC_ALG == TCM
     // periodically send gc timestamp to other nodes
     uint64_t last_gc_send_time = get_sys_clock();
@@ -52,10 +51,12 @@ OutputThread::run()
         for (uint32_t i = output_thread_id; i < g_num_worker_threads; i += g_num_input_threads) {
             uint32_t tid = i;
             uint64_t t1 = get_sys_clock();
-            if (output_queues[tid]->pop(msg)) {
+            uint32_t num_msgs = output_queues[tid]->pop_batch(msg_batch, OUTPUT_QUEUE_BATCH);
+            INC_FLOAT_STATS(time_read_queue, get_sys_clock() - t1);
+            if (num_msgs > 0)
                 pop = true;
-                INC_FLOAT_STATS(time_read_queue, get_sys_clock() - t1);
-
+            for (uint32_t j = 0; j < num_msgs; j ++) {
+                msg = (Message *) msg_batch[j];
                 uint64_t t2 = get_sys_clock();
                 stats->_stats[GET_THD_ID]->_msg_count[msg->get_type()] ++;
                 stats->_stats[GET_THD_ID]->_msg_size[msg->get_type()] += msg->get_packet_len();
@@ -63,31 +64,29 @@ OutputThread::run()
                 assert(tid % g_num_input_threads == GET_THD_ID % g_num_input_threads);
 
                 INC_FLOAT_STATS(time_debug4, get_sys_clock() - t2);
+                INC_FLOAT_STATS(bytes_sent, msg->get_packet_len());
 #if ENABLE_MSG_BUFFER
-                uint32_t bytes = _transport->sendMsg(msg);
-                if (bytes > 0)
-                    last_send_time = get_sys_clock();
+                // the transport deletes msg after it is sent.
+                _transport->bufferMsg(msg);
 #else
 
                 INC_FLOAT_STATS(time_debug4, get_sys_clock() - t2);
                 _last_output_time = get_sys_clock();
                 _transport->sendMsg(msg);
-#endif
-                INC_FLOAT_STATS(bytes_sent, msg->get_packet_len());
                 delete msg;
+#endif
                 INC_FLOAT_STATS(time_send_msg, get_sys_clock() - t2);
-            } else
-                INC_FLOAT_STATS(time_read_queue, get_sys_clock() - t1);
+            }
         }
+        // [NET_EMU] release the packets whose emulated delay has passed.
+        _transport->sendDelayedMsg();
+        _transport->pollSend();
 
 #if ENABLE_MSG_BUFFER
+        // each destination is flushed on its own deadline.
         uint64_t t2 = get_sys_clock();
-        // TODO. consider checking this per output socket. right now, an output socket can be starved.
-        uint32_t max_wait_time = 200 * g_max_num_active_txns;
-        if (get_sys_clock() - last_send_time > max_wait_time) {
-            _transport->sendBufferedMsg();
+        if (_transport->sendDueMsg() > 0) {
             INC_FLOAT_STATS(time_send_msg, get_sys_clock() - t2);
-            last_send_time = get_sys_clock();
             continue;
         }
 #endif
@@ -134,6 +133,7 @@ OutputThread::global_sync()
         if (bytes != msg->get_packet_len())
             _transport->sendBufferedMsg();
     }
+    _transport->pollSend();
 }
 
 void
@@ -148,6 +148,9 @@ OutputThread::terminate()
         if (bytes != msg->get_packet_len())
             _transport->sendBufferedMsg();
     }
+    // TERMINATE must not be left in the delay queues of network emulation.
+    _transport->sendBufferedMsg();
+    _transport->pollSend();
     _terminated = true;
 }
 
@@ -6,6 +6,9 @@
 
 class Transport;
 
+// max number of messages taken from an output queue at a time.
+#define OUTPUT_QUEUE_BATCH 16
+
 class OutputThread : public Thread
 {
 public:
@@ -9,6 +9,8 @@ void print_usage() {
     printf("\t-dINT       ; PRT_LAT_DISTR\n");
     printf("\t-mINT       ; MULTI_VERSION (if turned on)\n");
     printf("\t-GaINT      ; ABORT_PENALTY (in us)\n");
+    printf("\t-GmINT      ; MAX_ABORT_PENALTY (in ns)\n");
+    printf("\t-GhINT      ; HOT_KEY_ABORTS\n");
     printf("\t-GtINT      ; TS_ALLOC\n");
     printf("\t-GkINT      ; KEY_ORDER\n");
     printf("\t-GWFLOAT    ; WARMUP_TIME\n");
@@ -39,11 +41,25 @@ void print_usage() {
     printf("[TICTOC]:\n");
     printf("\t-CwINT      ; MAX_NUM_WAITS\n");
     printf("\t-CrINT      ; READ_INTENSITY_THRESH\n");
+    printf("[DL_DETECT]:\n");
+    printf("\t-ClINT      ; DL_DETECT_INTERVAL (in us)\n");
+    printf("[SILO]:\n");
+    printf("\t-CeINT      ; SILO_EPOCH_INTERVAL (in ms)\n");
+    printf("[CALVIN]:\n");
+    printf("\t-CsINT      ; CALVIN_EPOCH_INTERVAL (in us)\n");
     printf("[Distributed DBMS]:\n");
-    printf("\t-DxINT      ; MAX_NUM_ACTIVE_TXNS\n");
+    printf("\t-DxINT      ; MAX_NUM_ACTIVE_TXNS (native txns per server thread)\n");
     printf("\t-DiINT      ; NUM_INPUT_THREADS (NUM_OUTPUT_THREADS)\n");
     printf("\t-Df STRING  ; ifconfig file\n");
     printf("\t-DcINT      ; LOCAL_CACHE_SIZE\n");
+    printf("\t-DpINT      ; RECV_BUSY_POLL\n");
+    printf("\t-DtINT      ; TRANSPORT_TYPE (1: TCP, 2: SHM, 3: URING)\n");
+    printf("\t-DnINT      ; node id (TRANSPORT_SHM)\n");
+    printf("\t-DqINT      ; INOUT_QUEUE_SIZE\n");
+    printf("\t-DdINT      ; NET_EMU_DELAY\n");
+    printf("\t-DjINT      ; NET_EMU_JITTER\n");
+    printf("\t-DbINT      ; NET_EMU_BANDWIDTH\n");
+    printf("\t-De STRING  ; per-link network emulation file\n");
     printf("\n");
 }
 
@@ -74,6 +90,10 @@ void parser(int argc, char * argv[]) {
             // Global
             if (argv[i][2] == 'a')
                 g_abort_penalty = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'm')
+                g_max_abort_penalty = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'h')
+                g_hot_key_aborts = atoi( &argv[i][3] );
             else if (argv[i][2] == 't')
                 g_ts_alloc = atoi( &argv[i][3] );
             else if (argv[i][2] == 'k')
@@ -122,6 +142,12 @@ void parser(int argc, char * argv[]) {
                 g_max_num_waits = atoi( &argv[i][3] );
             else if (argv[i][2] == 'r')
                 g_read_intensity_thresh = atof( &argv[i][3] );
+            else if (argv[i][2] == 'l')
+                g_dl_detect_interval = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'e')
+                g_silo_epoch_interval = atoi( &argv[i][3] );
+            else if (argv[i][2] == 's')
+                g_calvin_epoch_interval = atoi( &argv[i][3] );
             else assert(false);
         } else if (argv[i][1] == 'D') {
             if (argv[i][2] == 'x')
@@ -133,6 +159,22 @@ void parser(int argc, char * argv[]) {
                 strcpy( ifconfig_file, argv[++i]);
             else if (argv[i][2] == 'c')
                 g_local_cache_size = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'p')
+                g_recv_busy_poll = atoi( &argv[i][3] );
+            else if (argv[i][2] == 't')
+                g_transport_type = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'n')
+                g_node_id = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'q')
+                g_inout_queue_size = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'd')
+                g_net_emu_delay = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'j')
+                g_net_emu_jitter = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'b')
+                g_net_emu_bandwidth = atoi( &argv[i][3] );
+            else if (argv[i][2] == 'e')
+                strcpy( net_emu_file, argv[++i]);
             else assert(false);
         } else if (argv[i][1] == 'o') {
             i++;
@@ -17,6 +17,16 @@ public:
     access_t type;
 };
 
+#if CC_ALG == CALVIN
+// A logical lock of a txn on node_id. CALVIN declares the locks of a txn before it runs.
+// key: | table_id (8 bits) | key in the table (56 bits) |
+struct LockRequest {
+    uint64_t     key;
+    uint32_t     node_id;
+    access_t     type;
+};
+#endif
+
 class QueryBase {
 public:
     QueryBase() { _isolation_level = SR; }
@@ -26,7 +36,21 @@ public:
     virtual uint32_t serialize(char * &raw_data) { assert(false); }
 
     Isolation     get_isolation_level() { return _isolation_level; }
+    // for the abort statistics of ADAPTIVE_BACKOFF.
+    virtual uint32_t    get_txn_type() { return 0; }
     virtual bool        is_all_remote_readonly() { return false; }
+#if CC_ALG == CALVIN
+    // every tuple accessed by the txn must be covered by one of the locks.
+    virtual void        get_lock_set(vector<LockRequest> &locks) { assert(false); }
+protected:
+    static void         add_lock(vector<LockRequest> &locks, uint32_t table_id, uint64_t key,
+                                 uint32_t node_id, access_t type)
+    {
+        LockRequest lock = { ((uint64_t)table_id << 56) | key, node_id, type };
+        locks.push_back(lock);
+    }
+public:
+#endif
 #if CC_ALG == WAIT_DIE || CC_ALG == F_ONE || (CC_ALG == TICTOC && OCC_LOCK_TYPE == WAIT_DIE)
     uint64_t     get_ts() { return _txn_ts; }
     void         set_ts(uint64_t txn_ts) { _txn_ts = txn_ts; }
@@ -0,0 +1,102 @@
+#include "retry_scheduler.h"
+#include "manager.h"
+#include "helper.h"
+
+#if ADAPTIVE_BACKOFF
+
+RetryScheduler::RetryScheduler()
+{
+    _abort_rate = (uint32_t **) _mm_malloc(sizeof(uint32_t *) * g_num_worker_threads, 64);
+    for (uint32_t i = 0; i < g_num_worker_threads; i ++) {
+        _abort_rate[i] = (uint32_t *) _mm_malloc(sizeof(uint32_t) * MAX_TXN_TYPES, 64);
+        memset(_abort_rate[i], 0, sizeof(uint32_t) * MAX_TXN_TYPES);
+    }
+    _hot_keys = (HotKey *) _mm_malloc(sizeof(HotKey) * HOT_KEY_SLOTS, 64);
+    memset(_hot_keys, 0, sizeof(HotKey) * HOT_KEY_SLOTS);
+}
+
+uint64_t
+RetryScheduler::get_penalty(uint32_t thd_id, uint32_t txn_type, uint32_t num_aborts,
+                            uint64_t conflict_key)
+{
+    assert(txn_type < MAX_TXN_TYPES && num_aborts > 0);
+    uint32_t &rate = _abort_rate[thd_id][txn_type];
+    rate += (1024 - rate) / 16;
+    if (conflict_key != UINT64_MAX) {
+        HotKey * slot = latch_slot(conflict_key);
+        age(slot);
+        if (slot->key != conflict_key && slot->num_aborts == 0 && slot->owner == 0)
+            slot->key = conflict_key;
+        if (slot->key == conflict_key)
+            slot->num_aborts ++;
+        unlatch_slot(slot);
+    }
+
+    uint64_t window = g_abort_penalty << min(num_aborts - 1, (uint32_t)16);
+    // a txn type that rarely aborts is retried sooner. The scale is in [1/4, 1].
+    window = window * (256 + rate * 3 / 4) / 1024;
+    if (window > g_max_abort_penalty)
+        window = g_max_abort_penalty;
+    return window * glob_manager->rand_double();
+}
+
+void
+RetryScheduler::commit(uint32_t thd_id, uint32_t owner, uint32_t txn_type, uint64_t conflict_key)
+{
+    assert(txn_type < MAX_TXN_TYPES);
+    uint32_t &rate = _abort_rate[thd_id][txn_type];
+    rate -= rate / 16;
+    release(owner, conflict_key);
+}
+
+bool
+RetryScheduler::try_restart(uint32_t owner, uint64_t conflict_key)
+{
+    if (conflict_key == UINT64_MAX)
+        return true;
+    HotKey * slot = latch_slot(conflict_key);
+    age(slot);
+    bool ready = true;
+    if (slot->key == conflict_key && slot->num_aborts >= g_hot_key_aborts) {
+        if (slot->owner == 0) {
+            slot->owner = owner + 1;
+            INC_INT_STATS(num_retries_serialized, 1);
+        }
+        ready = (slot->owner == owner + 1);
+    }
+    unlatch_slot(slot);
+    return ready;
+}
+
+void
+RetryScheduler::release(uint32_t owner, uint64_t conflict_key)
+{
+    if (conflict_key == UINT64_MAX)
+        return;
+    HotKey * slot = latch_slot(conflict_key);
+    if (slot->key == conflict_key && slot->owner == owner + 1)
+        slot->owner = 0;
+    unlatch_slot(slot);
+}
+
+RetryScheduler::HotKey *
+RetryScheduler::latch_slot(uint64_t key)
+{
+    HotKey * slot = &_hot_keys[key % HOT_KEY_SLOTS];
+    while (!ATOM_CAS(slot->latch, false, true))
+        PAUSE
+    return slot;
+}
+
+void
+RetryScheduler::age(HotKey * slot)
+{
+    uint64_t epoch = get_sys_clock() / HOT_KEY_EPOCH;
+    if (epoch > slot->epoch) {
+        uint64_t num_epochs = epoch - slot->epoch;
+        slot->num_aborts = (num_epochs >= 32)? 0 : slot->num_aborts >> num_epochs;
+        slot->epoch = epoch;
+    }
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "global.h"
+
+#if ADAPTIVE_BACKOFF
+
+// max number of txn types of a workload.
+#define MAX_TXN_TYPES       8
+// number of slots in the hot key table. Keys are hashed into the slots.
+#define HOT_KEY_SLOTS       4096
+// the abort count of a hot key is halved every epoch (in ns).
+#define HOT_KEY_EPOCH       (10 * 1000 * 1000)
+
+// Adaptive retry of aborted txns, shared by the worker threads of a node.
+//
+// The penalty of an aborted txn is a random time (full jitter) in a window of
+//   ABORT_PENALTY * 2^(num_aborts - 1)
+// scaled by the recent abort rate of its txn type, and at most MAX_ABORT_PENALTY.
+//
+// Aborts are also counted per conflicting key. The count is halved every HOT_KEY_EPOCH,
+// so it follows the recent abort rate of the key. A slot tracks one key, tagged in the
+// slot; another key hashed to it is not counted until the count decays to zero.
+// A retry that conflicted on a key with at least HOT_KEY_ABORTS recent aborts restarts
+// only after it takes the retry slot of the key, which it holds until it commits or
+// aborts again. So the retries on a hot key run one after another.
+class RetryScheduler {
+public:
+    RetryScheduler();
+
+    // returns the penalty (in ns) of the native txn of the thread.
+    uint64_t     get_penalty(uint32_t thd_id, uint32_t txn_type, uint32_t num_aborts,
+                             uint64_t conflict_key);
+    void         commit(uint32_t thd_id, uint32_t owner, uint32_t txn_type, uint64_t conflict_key);
+
+    // The owner is the native txn slot of the retry (ServerThread::retry_owner), since
+    // a thread runs several native txns.
+    // whether the retry may restart now. conflict_key is the key of its last abort.
+    bool         try_restart(uint32_t owner, uint64_t conflict_key);
+    // release the retry slot if the owner holds it.
+    void         release(uint32_t owner, uint64_t conflict_key);
+private:
+    struct HotKey {
+        volatile bool   latch;
+        // owner + 1. 0 if no retry holds the slot.
+        uint32_t        owner;
+        uint64_t        key;
+        uint32_t        num_aborts;
+        // the epoch of the last update of num_aborts.
+        uint64_t        epoch;
+    };
+    // returns the slot of the key, latched.
+    HotKey *     latch_slot(uint64_t key);
+    void         unlatch_slot(HotKey * slot) { slot->latch = false; }
+    // halve num_aborts for each epoch passed since the last update.
+    void         age(HotKey * slot);
+
+    // per thread, the abort rate of each txn type in 1/1024. Each commit or abort
+    // moves the rate 1/16 of the way toward 0 or 1024.
+    uint32_t **  _abort_rate;
+    HotKey *     _hot_keys;
+};
+
+#endif
@@ -13,6 +13,11 @@
 #include "txn_table.h"
 #include "transport.h"
 #include "cc_manager.h"
+#include "lock_manager.h"
+#include "dl_detect.h"
+#include "sequencer.h"
+#include "retry_scheduler.h"
+#include "caching.h"
 #if CC_ALG == MAAT
 #include "maat_manager.h"
 #endif
@@ -24,13 +29,30 @@ ServerThread::ServerThread(uint64_t thd_id)
 {
     pthread_mutex_init(&cond_mutex, NULL);
     pthread_cond_init (&cond, NULL);
-    _msg = NULL;
-    _native_txn = NULL;
+    _msg_batch_size = 0;
+    _msg_batch_pos = 0;
+    pthread_mutex_init(&_ready_latch, NULL);
+    _has_ready_ids = false;
+    _ready_pos = 0;
+    _max_num_active_txns = g_max_num_active_txns;
+    _native_txns = new NativeTxn [_max_num_active_txns];
+    for (uint32_t i = 0; i < _max_num_active_txns; i ++) {
+        _native_txns[i].txn = NULL;
+        _native_txns[i].ready_time = 0;
+#if ADAPTIVE_BACKOFF
+        _native_txns[i].retry_key = UINT64_MAX;
+#endif
+    }
     already_printed_debug = false;
+#if CC_ALG == DL_DETECT
+    _dl_epoch = 0;
+    _dl_edges_sent = false;
+#endif
 }
 
-// Each thread executes at most one active transaction.
-// If the transaction has aborted or is waiting for a lock, it will sleep, waiting for a signal.
+// Each thread executes at most _max_num_active_txns native transactions, interleaved
+// with the sub-txns of remote nodes. A transaction that waits for a lock or a remote
+// response is parked, and resumed by a wakeup or the response message.
 
 // For local miss, suspend the txn in txn_table
 // For txn abort, add the txn to abort_buffer
@@ -60,24 +82,25 @@ RC ServerThread::run() {
     bool sim_done = false;
     TxnManager * system_txn_man = new TxnManager(this, false);
     uint64_t last_stats_cp_time = init_time;
+#if CC_ALG == DL_DETECT
+    uint64_t last_dl_detect_time = init_time;
+#endif
+#if CC_ALG == CALVIN
+    uint64_t last_batch_time = init_time;
+#endif
     Message * msg = NULL;
     TxnManager * txn_man = NULL;
     //////////////////////////
     // Main loop
     //////////////////////////
     while (true) {
+#if CC_ALG == TICTOC && CACHE_PUSH
+        // send the pushes batched in the last iteration.
+        local_cache_man->send_pushes();
+#endif
         // try to get job from waiting buffer
-        // TODO. waiting buffer can be optimized.
-        txn_man = NULL;
         uint64_t t0 = get_sys_clock();
-        for (auto txn : _wait_buffer)
-        {
-            if (txn->is_txn_ready()) {
-                _wait_buffer.erase(txn);
-                txn_man = txn;
-                break;
-            }
-        }
+        txn_man = next_ready_txn();
         INC_FLOAT_STATS(time_wait_buffer, get_sys_clock() - t0);
         uint64_t t2 = get_sys_clock();
         if (txn_man) {
@@ -93,13 +116,22 @@ RC ServerThread::run() {
             stats->checkpoint();
             last_stats_cp_time += STATS_CP_INTERVAL * 1000000;
         }
+#if CC_ALG == DL_DETECT
+        if (get_sys_clock() - last_dl_detect_time > g_dl_detect_interval * 1000) {
+            detect_deadlocks();
+            last_dl_detect_time = get_sys_clock();
+        }
+#endif
+#if CC_ALG == CALVIN
+        if (get_thd_id() == 0 && get_sys_clock() - last_batch_time > g_calvin_epoch_interval * 1000) {
+            close_batch();
+            last_batch_time = get_sys_clock();
+        }
+#endif
 
         // For Distributed DBMS
-        if (_msg || input_queues[get_thd_id()]->pop(msg)) {
-            if (_msg) {
-                msg = _msg;
-                _msg = NULL;
-            }
+        if (has_msg()) {
+            msg = next_msg();
             INC_FLOAT_STATS(time_read_input_queue, get_sys_clock() - t1);
             uint64_t t2 = get_sys_clock();
             // make sure the correct txn_id is received.
@@ -113,13 +145,21 @@ RC ServerThread::run() {
                     || msg->get_type() == Message::COMMIT_REQ
                     || msg->get_type() == Message::ABORT_REQ)
                 {
-                    assert((CC_ALG == TICTOC && ENABLE_LOCAL_CACHING) || CC_ALG == MAAT);  // maat allows short-cut abort
+                    // maat allows short-cut abort.
+                    // CALVIN releases the locks of a txn on every node in its lock set.
+                    assert((CC_ALG == TICTOC && ENABLE_LOCAL_CACHING) || CC_ALG == MAAT || CC_ALG == CALVIN);
                     system_txn_man->get_cc_manager()->init();
                     system_txn_man->set_txn_id( msg->get_txn_id() );
                     system_txn_man->process_msg(msg);
                     DELETE(Message, msg);
                     continue;
                 }
+                if (msg->get_type() == Message::WOUND_REQ) {
+                    // the wounded txn has already finished.
+                    assert(CC_ALG == WOUND_WAIT);
+                    DELETE(Message, msg);
+                    continue;
+                }
                 M_ASSERT(msg->get_type() == Message::REQ || msg->get_type() == Message::CLIENT_REQ,
                         "msg->type = %s\n", msg->get_name().c_str());
                 txn_man = new TxnManager(msg, this);
@@ -137,10 +177,14 @@ RC ServerThread::run() {
         // TODO. should balance the priority between abort queue and input queue.
         uint64_t t3 = get_sys_clock();
         // re-execute aborted txn
-        if (_native_txn && _native_txn->get_txn_state() == TxnManager::ABORTED && get_sys_clock() > _ready_time) {
-            TxnManager * restart_txn = new TxnManager( _native_txn );
+        NativeTxn * native = NULL;
+        for (uint32_t i = 0; i < _max_num_active_txns && !native; i ++)
+            if (is_retry_ready(&_native_txns[i]))
+                native = &_native_txns[i];
+        if (native) {
+            TxnManager * restart_txn = new TxnManager( native->txn );
 #if CC_ALG == MAAT
-            MaaTManager *maatman = (MaaTManager*)(_native_txn->get_cc_manager());
+            MaaTManager *maatman = (MaaTManager*)(native->txn->get_cc_manager());
             uint64_t rf = ATOM_SUB_FETCH(maatman->_refcount, 1);
 
             // TODO. this is a hack now
@@ -154,22 +198,22 @@ RC ServerThread::run() {
             if (rf == 0)
 #endif
             {
-                txn_table->remove_txn(_native_txn);
-                delete _native_txn;
+                txn_table->remove_txn(native->txn);
+                delete native->txn;
             }
 
-            _native_txn = restart_txn;
-            txn_table->add_txn( _native_txn );
+            native->txn = restart_txn;
+            txn_table->add_txn( restart_txn );
 
-            rc = _native_txn->start_execute();
-            handle_req_finish(rc, _native_txn);
+            rc = restart_txn->start_execute();
+            handle_req_finish(rc, restart_txn);
             if (rc == COMMIT)
-                assert(_native_txn == NULL);
+                assert(native->txn == NULL);
             INC_FLOAT_STATS(time_process_txn, get_sys_clock() - t3);
             continue;
         }
         if (get_sys_clock() - init_time > (g_warmup_time + g_run_time) * BILLION) {
-            if (!sim_done && !_native_txn) {
+            if (!sim_done && _num_active_txns == 0) {
                 sim_done = true;
                 glob_manager->worker_thread_done();
                 glob_manager->set_gc_ts( (uint64_t)-1 );
@@ -181,8 +225,9 @@ RC ServerThread::run() {
             }
             continue;
         }
-        // Generate a new transaction
-        if (!_native_txn) {
+        // Generate a new transaction in a free slot
+        native = get_native(NULL);
+        if (native) {
             INC_INT_STATS(num_home_txn, 1);
             QueryBase * query = GET_WORKLOAD->gen_query();
             // txn_id format:
@@ -191,39 +236,48 @@ RC ServerThread::run() {
             txn_id = txn_id * g_num_server_threads + _thd_id;
             txn_id = txn_id * g_num_server_nodes + g_node_id;
 
-            _native_txn = (TxnManager *) MALLOC(sizeof(TxnManager));
-            new(_native_txn) TxnManager(query, this);
-            _native_txn->set_txn_id( txn_id );
-            txn_table->add_txn( _native_txn );
+            TxnManager * new_txn = (TxnManager *) MALLOC(sizeof(TxnManager));
+            new(new_txn) TxnManager(query, this);
+            new_txn->set_txn_id( txn_id );
+            txn_table->add_txn( new_txn );
+            native->txn = new_txn;
+            _num_active_txns ++;
 
-            rc = _native_txn->start_execute();
-            handle_req_finish(rc, _native_txn);
+            rc = new_txn->start_execute();
+            handle_req_finish(rc, new_txn);
             if (rc == COMMIT)
-                assert(_native_txn == NULL);
+                assert(native->txn == NULL);
             INC_FLOAT_STATS(time_process_txn, get_sys_clock() - t3);
             continue;
         }
-        assert(!_msg);
-        assert(_native_txn);
-        if (_native_txn->get_txn_state() == TxnManager::ABORTED) {
+        assert(_msg_batch_pos == _msg_batch_size);
+        assert(_num_active_txns == _max_num_active_txns);
+        // if all the native txns have aborted, wait for the earliest restart.
+        int64_t wait_time = INT64_MAX;
+        for (uint32_t i = 0; i < _max_num_active_txns && wait_time > 0; i ++) {
+            TxnManager * txn = _native_txns[i].txn;
+            if (txn->get_txn_state() != TxnManager::ABORTED)
+                wait_time = 0;
 #if ENABLE_LOCAL_CACHING
-            if (!_native_txn->is_all_remote_readonly())
+            else if (txn->is_all_remote_readonly())
+                wait_time = 0;
 #endif
-            {
-                int64_t wait_time = _ready_time - get_sys_clock();
-                if (wait_time > 100 * 1000)
-                    PAUSE100
-            }
+            else
+                wait_time = min(wait_time, (int64_t)(_native_txns[i].ready_time - get_sys_clock()));
+        }
+        if (wait_time > 0) {
+            if (wait_time > 100 * 1000)
+                PAUSE100
             INC_FLOAT_STATS(time_abort_queue, get_sys_clock() - t3);
             continue;
         }
 
-        bool done = false;
-        for (auto txn_man : _wait_buffer)
-            if (txn_man->is_txn_ready())
-                done = true;
-
-        if (done || input_queues[get_thd_id()]->pop(_msg)) {
+#if CC_ALG == WOUND_WAIT
+        for (uint32_t i = 0; i < _max_num_active_txns; i ++)
+            if (_native_txns[i].txn->get_txn_state() != TxnManager::ABORTED)
+                ((LockManager *)_native_txns[i].txn->get_cc_manager())->forward_wound();
+#endif
+        if (has_ready_txn() || has_msg()) {
             continue;
         }
         PAUSE100
@@ -232,12 +286,176 @@ RC ServerThread::run() {
     INC_FLOAT_STATS(run_time, get_sys_clock() - init_time);
     if (get_thd_id() == 0) {
         uint32_t size = txn_table->get_size();
-        M_ASSERT(size == 0, "size = %d", size);
+        // the one-way COMMIT_REQ of CALVIN may still be in flight for some sub-txns.
+        M_ASSERT(size == 0 || CC_ALG == CALVIN, "size = %d", size);
     }
     delete system_txn_man;
     return FINISH;
 }
 
+ServerThread::NativeTxn *
+ServerThread::get_native(TxnManager * txn)
+{
+    for (uint32_t i = 0; i < _max_num_active_txns; i ++)
+        if (_native_txns[i].txn == txn)
+            return &_native_txns[i];
+    return NULL;
+}
+
+bool
+ServerThread::is_retry_ready(NativeTxn * native)
+{
+    if (!native->txn || native->txn->get_txn_state() != TxnManager::ABORTED
+        || get_sys_clock() <= native->ready_time)
+        return false;
+#if ADAPTIVE_BACKOFF
+    return retry_scheduler->try_restart(retry_owner(native), native->retry_key);
+#else
+    return true;
+#endif
+}
+
+// refill the batch from the input queue if it is consumed.
+bool
+ServerThread::has_msg()
+{
+    if (_msg_batch_pos == _msg_batch_size) {
+        _msg_batch_size = input_queues[get_thd_id()]->pop_batch(_msg_batch, INPUT_QUEUE_BATCH);
+        _msg_batch_pos = 0;
+    }
+    return _msg_batch_pos < _msg_batch_size;
+}
+
+Message *
+ServerThread::next_msg()
+{
+    assert(_msg_batch_pos < _msg_batch_size);
+    return (Message *) _msg_batch[_msg_batch_pos ++];
+}
+
+void
+ServerThread::wakeup(uint64_t txn_id)
+{
+#if CC_ALG != CALVIN
+    pthread_mutex_lock(&_ready_latch);
+    _ready_ids.push_back(txn_id);
+    _has_ready_ids = true;
+    pthread_mutex_unlock(&_ready_latch);
+#endif
+}
+
+bool
+ServerThread::has_ready_txn()
+{
+#if CC_ALG == CALVIN
+    // the sequencer grants the locks without waking up the txns, so they are polled.
+    for (auto it : _wait_buffer)
+        if (it.second->is_txn_ready())
+            return true;
+    return false;
+#else
+    return _ready_pos < _ready_batch.size() || _has_ready_ids;
+#endif
+}
+
+TxnManager *
+ServerThread::next_ready_txn()
+{
+#if CC_ALG == CALVIN
+    for (auto it : _wait_buffer)
+        if (it.second->is_txn_ready()) {
+            _wait_buffer.erase(it.first);
+            return it.second;
+        }
+    return NULL;
+#else
+    while (true) {
+        if (_ready_pos == _ready_batch.size()) {
+            if (!_has_ready_ids)
+                return NULL;
+            _ready_batch.clear();
+            _ready_pos = 0;
+            pthread_mutex_lock(&_ready_latch);
+            _ready_batch.swap(_ready_ids);
+            _has_ready_ids = false;
+            pthread_mutex_unlock(&_ready_latch);
+        }
+        // the id may be stale, or the txn may wait for more locks.
+        auto it = _wait_buffer.find(_ready_batch[_ready_pos ++]);
+        if (it != _wait_buffer.end() && it->second->is_txn_ready()) {
+            TxnManager * txn = it->second;
+            _wait_buffer.erase(it);
+            return txn;
+        }
+    }
+#endif
+}
+
+#if CC_ALG == DL_DETECT
+void
+ServerThread::detect_deadlocks()
+{
+    if (get_thd_id() == 0) {
+        dl_detector->detect();
+        // an empty edge list is sent once, to clear the edges on the other nodes.
+        uint32_t size;
+        char * data;
+        dl_detector->get_local_edges(size, data);
+        if (size > 0 || _dl_edges_sent) {
+            for (uint32_t i = 0; i < g_num_server_nodes; i ++) {
+                if (i == g_node_id) continue;
+                char * msg_data = NULL;
+                if (size > 0) {
+                    msg_data = new char [size];
+                    memcpy(msg_data, data, size);
+                }
+                Message * msg = new Message(Message::DL_EDGES, i, 0, size, msg_data);
+                while (!output_queues[get_thd_id()]->push((uint64_t)msg)) {
+                    PAUSE10
+                }
+            }
+        }
+        _dl_edges_sent = (size > 0);
+        delete [] data;
+    }
+    bool new_victims = (dl_detector->get_epoch() != _dl_epoch);
+    _dl_epoch = dl_detector->get_epoch();
+    vector<uint64_t> edges;
+    for (auto it : _wait_buffer) {
+        TxnManager * txn_man = it.second;
+        if (txn_man->is_txn_ready())
+            continue;
+        LockManager * manager = (LockManager *) txn_man->get_cc_manager();
+        if (new_victims && dl_detector->is_victim(txn_man->get_txn_id())) {
+            manager->wound_victim();
+            wakeup(txn_man->get_txn_id());
+        } else
+            manager->get_wait_edges(edges);
+    }
+    dl_detector->set_local_edges(get_thd_id(), edges);
+}
+#endif
+
+#if CC_ALG == CALVIN
+void
+ServerThread::close_batch()
+{
+    uint32_t size;
+    char * data;
+    sequencer->close_batch(size, data);
+    for (uint32_t i = 0; i < g_num_server_nodes; i ++) {
+        if (i == g_node_id) continue;
+        char * msg_data = new char [size];
+        memcpy(msg_data, data, size);
+        Message * msg = new Message(Message::CALVIN_BATCH, i, 0, size, msg_data);
+        while (!output_queues[get_thd_id()]->push((uint64_t)msg)) {
+            PAUSE10
+        }
+    }
+    delete [] data;
+}
+#endif
+
 // RCOK: txn active, do nothing.
 // COMMIT: txn commits
 // ABORT: txn aborts
@@ -253,7 +471,10 @@ ServerThread::handle_req_finish(RC rc, TxnManager * &txn_man)
         return;
     else if (rc == WAIT) {
         INC_INT_STATS(num_waits, 1);
-        _wait_buffer.insert(txn_man);
+        _wait_buffer[txn_man->get_txn_id()] = txn_man;
+        // the txn may have become ready before it is in the wait buffer.
+        if (txn_man->is_txn_ready())
+            wakeup(txn_man->get_txn_id());
         return;
     }
     else if (rc == RCOK) {
@@ -292,8 +513,12 @@ ServerThread::handle_req_finish(RC rc, TxnManager * &txn_man)
 #endif
             txn_man = NULL;
         } else {
+            NativeTxn * native = get_native(txn_man);
             if (rc == ABORT) {
+                assert(native);
+                // a txn of CALVIN only aborts by its own logic, which is deterministic.
                 if ((WORKLOAD == TPCC && txn_man->get_store_procedure()->is_self_abort())
+                    || CC_ALG == CALVIN
                     || (MAX_NUM_ABORTS > 0 && txn_man->get_num_aborts() >= MAX_NUM_ABORTS))
                 {
 #if CC_ALG == MAAT
@@ -306,15 +531,34 @@ ServerThread::handle_req_finish(RC rc, TxnManager * &txn_man)
                         DELETE(TxnManager, txn_man);
                     }
 
-                    assert(txn_man == _native_txn);
-                    _native_txn = NULL;
+                    native->txn = NULL;
                     txn_man = NULL;
+                    _num_active_txns --;
                     INC_INT_STATS(num_aborts_terminate, 1);
+#if ADAPTIVE_BACKOFF
+                    retry_scheduler->release(retry_owner(native), native->retry_key);
+                    native->retry_key = UINT64_MAX;
+#endif
                     return;
                 }
                 INC_INT_STATS(num_aborts_restart, 1);
-                _ready_time = get_sys_clock() + g_abort_penalty * glob_manager->rand_double();
+#if ADAPTIVE_BACKOFF
+                retry_scheduler->release(retry_owner(native), native->retry_key);
+                native->retry_key = txn_man->get_store_procedure()->get_conflict_key();
+                native->ready_time = get_sys_clock() + retry_scheduler->get_penalty(get_thd_id(),
+                    txn_man->get_store_procedure()->get_query()->get_txn_type(),
+                    txn_man->get_num_aborts(), native->retry_key);
+#else
+                native->ready_time = get_sys_clock() + g_abort_penalty * glob_manager->rand_double();
+#endif
             } else {
+#if ADAPTIVE_BACKOFF
+                if (native) {
+                    retry_scheduler->commit(get_thd_id(), retry_owner(native),
+                        txn_man->get_store_procedure()->get_query()->get_txn_type(), native->retry_key);
+                    native->retry_key = UINT64_MAX;
+                }
+#endif
 #if CC_ALG == MAAT
                 MaaTManager *maatman = (MaaTManager*)(txn_man->get_cc_manager());
                 uint64_t rf = ATOM_SUB_FETCH(maatman->_refcount, 1);
@@ -327,10 +571,11 @@ ServerThread::handle_req_finish(RC rc, TxnManager * &txn_man)
                     txn_table->remove_txn(txn_man);
                     DELETE(TxnManager, txn_man);
                 }
-                if (txn_man == _native_txn)
-                    _native_txn = NULL;
+                if (native) {
+                    native->txn = NULL;
+                    _num_active_txns --;
+                }
                 txn_man = NULL;
-                _num_active_txns --;
                 // so we will always decrease the number of active txns in
                 // server_thread.cpp as committed (but still in the table) txn
                 // should not be seen as an active txn.
@@ -11,6 +11,9 @@ class Transport;
 class TxnManager;
 class Message;
 
+// max number of messages taken from the input queue at a time.
+#define INPUT_QUEUE_BATCH 16
+
 class ServerThread : public Thread {
 public:
     ServerThread(uint64_t thd_id);
@@ -18,20 +21,68 @@ public:
 
     void signal();
 
-    TxnManager * get_native_txn() { return _native_txn; }
+    // a waiting txn of this thread may have become ready. Called by any thread.
+    void wakeup(uint64_t txn_id);
     pthread_mutex_t cond_mutex;
     pthread_cond_t     cond;
 private:
     void handle_req_finish(RC rc, TxnManager * &txn_man);
+#if CC_ALG == DL_DETECT
+    // publish the waits-for edges of the waiting txns, and abort the deadlock victims.
+    // Thread 0 also searches for deadlocks and sends the edges of this node.
+    void detect_deadlocks();
+    uint64_t         _dl_epoch;
+    bool             _dl_edges_sent;
+#endif
+#if CC_ALG == CALVIN
+    // close the batch of new txns of this node and send it to the other nodes.
+    // Only called by thread 0.
+    void close_batch();
+#endif
 
-    TxnManager *     _native_txn;
-    uint64_t         _ready_time;
-    // wait_buffer
-    set<TxnManager *> _wait_buffer;
-    Message *        _msg;
+    // A thread runs up to _max_num_active_txns native txns. A native txn waiting
+    // for a remote node stays in the txn_table while the thread starts other txns.
+    struct NativeTxn {
+        TxnManager *     txn;    // NULL if the slot is free.
+        uint64_t         ready_time;
+#if ADAPTIVE_BACKOFF
+        // the conflict key of the last abort of the txn.
+        uint64_t         retry_key;
+#endif
+    };
+    NativeTxn *      _native_txns;
+    // returns the slot of a native txn, or NULL.
+    NativeTxn *      get_native(TxnManager * txn);
+    // whether the aborted native txn can restart now.
+    bool             is_retry_ready(NativeTxn * native);
+#if ADAPTIVE_BACKOFF
+    // a node-wide id of a native slot. Hot-key retry slots are owned by native slots.
+    uint32_t         retry_owner(NativeTxn * native)
+    { return get_thd_id() * _max_num_active_txns + (native - _native_txns); }
+#endif
+    // wait_buffer, by txn_id.
+    map<uint64_t, TxnManager *> _wait_buffer;
+    // ids of the waiting txns that may have become ready, pushed by wakeup().
+    // A txn is resumed only if it is still waiting and is ready.
+    pthread_mutex_t  _ready_latch;
+    vector<uint64_t> _ready_ids;
+    volatile bool    _has_ready_ids;
+    // the ids taken from _ready_ids, only accessed by this thread.
+    vector<uint64_t> _ready_batch;
+    uint32_t         _ready_pos;
+    bool             has_ready_txn();
+    // returns a ready txn removed from _wait_buffer, or NULL.
+    TxnManager *     next_ready_txn();
+    // messages popped from the input queue but not processed yet.
+    bool             has_msg();
+    Message *        next_msg();
+    uint64_t         _msg_batch[INPUT_QUEUE_BATCH];
+    uint32_t         _msg_batch_size;
+    uint32_t         _msg_batch_pos;
     // So only malloc at the beginning
 
     uint64_t     _client_node_id;
+    // number of native txns, including the aborted ones waiting to restart.
     uint64_t     _num_active_txns;
     uint64_t     _max_num_active_txns;
     // For timestamp allocation
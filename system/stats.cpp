@@ -56,6 +56,10 @@ Stats_thd::copy_from(Stats_thd * stats_thd)
 Stats::Stats()
 {
     _num_cp = 0;
+    dl_detect_time = 0;
+    dl_wait_time = 0;
+    cycle_detect = 0;
+    deadlock = 0;
     _stats = new Stats_thd * [g_total_num_threads];
     for (uint32_t i = 0; i < g_total_num_threads; i++) {
         _stats[i] = (Stats_thd *) _mm_malloc(sizeof(Stats_thd), 64);
@@ -112,6 +116,9 @@ void Stats::output(std::ostream * os)
                 _stats[i]->_msg_committed_size[n] -= base->_stats[i]->_msg_committed_size[n];
             }
         }
+        dl_detect_time -= base->dl_detect_time;
+        cycle_detect -= base->cycle_detect;
+        deadlock -= base->deadlock;
     }
 
     uint64_t total_num_commits = 0;
@@ -178,6 +185,30 @@ void Stats::output(std::ostream * os)
         out << ')' << endl;
 
     }
+    // network emulation: average delay per packet, scheduled vs. observed.
+    uint64_t num_emu_packets = 0;
+    double emu_delay = 0;
+    double real_delay = 0;
+    for (uint32_t tid = 0; tid < g_total_num_threads; tid ++) {
+        num_emu_packets += _stats[tid]->_int_stats[STAT_num_net_emu_packets];
+        emu_delay += _stats[tid]->_float_stats[STAT_net_emu_delay];
+        real_delay += _stats[tid]->_float_stats[STAT_net_real_delay];
+    }
+    if (num_emu_packets > 0) {
+        out << "    " << setw(30) << left << "avg_net_emu_delay (in us):"
+            << emu_delay / num_emu_packets / 1000 << endl;
+        out << "    " << setw(30) << left << "avg_net_real_delay (in us):"
+            << real_delay / num_emu_packets / 1000 << endl;
+    }
+#if CC_ALG == DL_DETECT
+    // deadlock detection runs, deadlocks found, and the time spent in detection.
+    out << "    " << setw(30) << left << "cycle_detect:" << cycle_detect << endl;
+    out << "    " << setw(30) << left << "deadlock:" << deadlock << endl;
+    out << "    " << setw(30) << left << "dl_detect_time:" << dl_detect_time / BILLION << endl;
+    if (cycle_detect > 0)
+        out << "    " << setw(30) << left << "avg_dl_detect_time (in us):"
+            << dl_detect_time / cycle_detect / 1000 << endl;
+#endif
 #if WORKLOAD == TPCC
     out << "TPCC Per Txn Type Commits/Aborts" << endl;
     out << "    " << setw(18) << left << "Txn Name"
@@ -332,6 +363,9 @@ Stats::copy_from(Stats * stats)
     // TODO. this checkpoint may be slightly inconsistent. But it should be fine.
     for (uint32_t i = 0; i < g_total_num_threads; i ++)
         _stats[i]->copy_from(stats->_stats[i]);
+    dl_detect_time = stats->dl_detect_time;
+    cycle_detect = stats->cycle_detect;
+    deadlock = stats->deadlock;
 }
 
 double
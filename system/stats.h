@@ -26,6 +26,9 @@ enum StatsFloat {
     STAT_time_send_msg,
     STAT_time_read_queue, // read output_queue
     STAT_time_output_idle,
+    // network emulation. delay added to each packet, as scheduled and as observed.
+    STAT_net_emu_delay,
+    STAT_net_real_delay,
 
     // Input Thread
     STAT_bytes_received,
@@ -78,10 +81,20 @@ enum StatsInt {
 
     STAT_num_aborts_restart,
     STAT_num_aborts_terminate,
+    // For WOUND_WAIT and DL_DETECT. Txns aborted because an older txn or the
+    // deadlock detector wounded them.
+    STAT_num_aborts_wound,
+    // For ADAPTIVE_BACKOFF. Retries that took the retry slot of a hot key.
+    STAT_num_retries_serialized,
 
     STAT_num_renewals,
     STAT_num_no_need_to_renewal,
 
+    // For message buffering. Number of sendmsg() batches.
+    STAT_num_msg_batches,
+    // network emulation. Number of packets held in the delay queues.
+    STAT_num_net_emu_packets,
+
     // For local caching
     STAT_num_cache_bypass,
     STAT_num_cache_reads,
@@ -91,6 +104,10 @@ enum StatsInt {
     STAT_num_cache_inserts,
     STAT_num_cache_updates,
     STAT_num_cache_evictions,
+    STAT_num_cache_admits,
+    STAT_num_cache_rejects,
+    STAT_num_cache_invalidations,
+    STAT_num_cache_extensions,
 
     STAT_num_local_hits,
     STAT_num_renew,
@@ -203,6 +220,8 @@ public:
         "time_send_msg",
         "time_read_queue",
         "time_output_idle",
+        "net_emu_delay",
+        "net_real_delay",
 
         // Input Thread
         "bytes_received",
@@ -252,10 +271,15 @@ public:
 
         "num_aborts_restart",
         "num_aborts_terminate",
+        "num_aborts_wound",
+        "num_retries_serialized",
 
         "num_renewals",
         "num_no_need_to_renewal",
 
+        "num_msg_batches",
+        "num_net_emu_packets",
+
         // For local caching
         "num_cache_bypass",
         "num_cache_reads",
@@ -266,6 +290,10 @@ public:
         "num_cache_inserts",
         "num_cache_updates",
         "num_cache_evictions",
+        "num_cache_admits",
+        "num_cache_rejects",
+        "num_cache_invalidations",
+        "num_cache_extensions",
 
         "num_local_hits",
         "num_renew",
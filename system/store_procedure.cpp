@@ -7,6 +7,7 @@
 #include "tpcc_query.h"
 #include "workload.h"
 #include "index_base.h"
+#include "index_hash.h"
 #include "tictoc_manager.h"
 #include "packetize.h"
 
@@ -18,6 +19,7 @@ StoreProcedure::~StoreProcedure()
 void
 StoreProcedure::init() {
     _self_abort = false;
+    _conflict_key = UINT64_MAX;
     _phase = 0;
     _curr_row = NULL;
     _curr_query_id = 0;
@@ -41,6 +43,14 @@ StoreProcedure::get_cc_manager()
     return _txn->get_cc_manager();
 }
 
+void
+StoreProcedure::set_conflict_key(INDEX * index, uint64_t key, RC rc)
+{
+    // keys of different indexes are told apart by the index.
+    if (rc == ABORT)
+        _conflict_key = key * 31 + index->get_index_id();
+}
+
 void
 StoreProcedure::txn_abort()
 {
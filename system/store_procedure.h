@@ -30,6 +30,9 @@ public:
     virtual void txn_abort();
     // for a sub transaction
     bool is_self_abort() { return _self_abort; }
+    // the key on which the txn was aborted when accessing a local tuple, or UINT64_MAX
+    // if the abort was not caused by an access (e.g., validation or a remote abort).
+    uint64_t get_conflict_key() { return _conflict_key; }
 
     access_t _local_miss_type;
     uint64_t _local_miss_key;
@@ -40,15 +43,29 @@ protected:
     type var = *(type *)row_t::get_value(schema, col, data);
 #define STORE_VALUE(var, schema, data, col) \
     row_t::set_value(schema, col, data, (char *)&var);
+// Add delta to a double column of _curr_row, accessed with INC_TYPE. The txn aborts
+// if the column could leave [min, max]. Without INC_SUPPORTED, it is a read-modify-write.
+#if INC_SUPPORTED
+#define INC_TYPE INC
+#define INC_VALUE(delta, min, max, schema, data, col) { \
+    rc = get_cc_manager()->add_increment(_curr_row, schema, col, delta, min, max); \
+    if (rc != RCOK) return rc; }
+#else
+#define INC_TYPE WR
+#define INC_VALUE(delta, min, max, schema, data, col) { \
+    double value = *(double *)row_t::get_value(schema, col, data) + (delta); \
+    if (value < (min) || value > (max)) return ABORT; \
+    row_t::set_value(schema, col, data, (char *)&value); }
+#endif
 
 #define GET_DATA(key, index, type) {{ \
     set<row_t *> * rows = NULL; \
     rc = get_cc_manager()->index_read(index, key, rows, 1); \
-    if (rc != RCOK) return rc; \
+    if (rc != RCOK) { set_conflict_key(index, key, rc); return rc; } \
     assert(!rows->empty()); \
     _curr_row = *rows->begin(); \
     rc = get_cc_manager()->get_row(_curr_row, type, _curr_data, key);\
-    if (rc != RCOK) return rc; }}
+    if (rc != RCOK) { set_conflict_key(index, key, rc); return rc; } }}
 
 
 #define REMOTE_ACCESS(node_id, key, type, table, index) {\
@@ -75,10 +92,12 @@ protected:
 
 
     CCManager *       get_cc_manager();
+    void              set_conflict_key(INDEX * index, uint64_t key, RC rc);
     QueryBase *       _query;
     TxnManager *      _txn;
 
     bool              _self_abort;
+    uint64_t          _conflict_key;
 
     bool              _is_single_partition;
     // [For distributed DBMS]
@@ -27,7 +27,9 @@
 #include "lock_manager.h"
 #include "f1_manager.h"
 #include "ideal_mvcc_manager.h"
-#if CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE
+#include "silo_manager.h"
+#include "calvin_manager.h"
+#if CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
 #include "row_lock.h"
 #endif
 #include "log.h"
@@ -85,6 +87,7 @@ TxnManager::TxnManager(TxnManager * txn)
     waiting_for_remote = false;
     waiting_for_lock = false;
     pthread_mutex_init( &_txn_lock, NULL );
+    _server_thread = txn->_server_thread;
 
     _txn_start_time = txn->_txn_start_time;
     _txn_restart_time = get_sys_clock();
@@ -104,6 +107,10 @@ TxnManager::TxnManager(TxnManager * txn)
     memset(_msg_count, 0, sizeof(uint64_t) * Message::NUM_MSG_TYPES);
     memset(_msg_size, 0, sizeof(uint64_t) * Message::NUM_MSG_TYPES);
     _cc_manager = CCManager::create(this);
+#if CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+    // a restarted txn keeps its timestamp, so it cannot be wounded forever.
+    ((LockManager *)_cc_manager)->set_ts( ((LockManager *)txn->get_cc_manager())->get_ts() );
+#endif
 }
 
 TxnManager::~TxnManager()
@@ -136,7 +143,11 @@ TxnManager::is_txn_ready()
 void
 TxnManager::set_txn_ready(RC rc)
 {
+    // the txn may finish as soon as it is ready, so it is not accessed afterwards.
+    uint64_t txn_id = get_txn_id();
+    ServerThread * thread = _server_thread;
     _cc_manager->set_txn_ready(rc);
+    thread->wakeup(txn_id);
 }
 
 void
@@ -164,7 +175,7 @@ TxnManager::update_stats()
         INC_INT_STATS(num_commits, 1);
         uint64_t latency = _finish_time - _txn_start_time;
         INC_FLOAT_STATS(txn_latency, latency);
-#if CC_ALG == NAIVE_TICTOC
+#if CC_ALG == NAIVE_TICTOC || CC_ALG == SILO
         INC_FLOAT_STATS(execute_phase, _lock_phase_start_time - _txn_restart_time);
         INC_FLOAT_STATS(lock_phase, _prepare_start_time - _lock_phase_start_time);
 #else
@@ -245,6 +256,14 @@ TxnManager::execute(bool restart)
         _lock_wait_time += get_sys_clock() - _lock_wait_start_time;
     waiting_for_lock = false;
     assert (_txn_state == RUNNING);
+#if CC_ALG == CALVIN
+    // a txn or sub-txn runs only after the sequencer grants its locks on this node.
+    if (((CalvinManager *)_cc_manager)->acquire_locks() == WAIT) {
+        waiting_for_lock = true;
+        _lock_wait_start_time = get_sys_clock();
+        return WAIT;
+    }
+#endif
     // remote request.
     if (is_sub_txn())
     {
@@ -265,7 +284,8 @@ TxnManager::execute(bool restart)
                                    get_txn_id(), 0, NULL));
             _cc_manager->abort();
         } else if (rc == WAIT) {
-            assert(CC_ALG == WAIT_DIE || (CC_ALG == TICTOC && OCC_WAW_LOCK));
+            assert(CC_ALG == WAIT_DIE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+                   || (CC_ALG == TICTOC && OCC_WAW_LOCK));
             waiting_for_lock = true;
             _lock_wait_start_time = get_sys_clock();
         }
@@ -275,13 +295,22 @@ TxnManager::execute(bool restart)
         _remote_txn_abort = false;
 
         uint64_t tt = get_sys_clock();
+#if CC_ALG == WOUND_WAIT
+        // a wounded txn must not start new sub-txns.
+        RC rc = ABORT;
+        if (((LockManager *)_cc_manager)->is_wounded()) {
+            INC_INT_STATS(num_aborts_wound, 1);
+        } else
+            rc = _store_procedure->execute();
+#else
         RC rc = _store_procedure->execute();
+#endif
         INC_FLOAT_STATS(logic, get_sys_clock() - tt);
 
         if (rc == RCOK) {
             if (_num_resp_expected == 0) {
                 assert(!_txn_abort);
-#if CC_ALG == NAIVE_TICTOC
+#if CC_ALG == NAIVE_TICTOC || CC_ALG == SILO
                 return process_lock_phase();
 #else
                 return process_2pc_prepare_phase();
@@ -313,7 +342,8 @@ TxnManager::execute(bool restart)
             // Otherwise, different batches may have different remote nodes.
             return continue_execute();
         } else if (rc == WAIT) {
-            assert(CC_ALG == WAIT_DIE || ((CC_ALG == TICTOC || CC_ALG == F_ONE) && OCC_WAW_LOCK));
+            assert(CC_ALG == WAIT_DIE || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
+                   || ((CC_ALG == TICTOC || CC_ALG == F_ONE) && OCC_WAW_LOCK));
             waiting_for_lock = true;
             _lock_wait_start_time = get_sys_clock();
             return rc;
@@ -329,6 +359,13 @@ TxnManager::execute(bool restart)
 RC
 TxnManager::process_msg(Message * msg)
 {
+#if CC_ALG == WOUND_WAIT
+    // handled before _msg is set, since a sub-txn waiting for a lock re-executes _msg.
+    if (msg->get_type() == Message::WOUND_REQ) {
+        ((LockManager *)_cc_manager)->process_wound_req(msg->get_data_size(), msg->get_data());
+        return RCOK;
+    }
+#endif
     _msg = msg;
     _msg_count[msg->get_type()] ++;
     _msg_size[msg->get_type()] += msg->get_packet_len();
@@ -349,7 +386,7 @@ TxnManager::process_msg(Message * msg)
         assert(waiting_for_remote);
         return process_remote_resp(msg);
     // 2PC prepare phase and amend phase.
-#if CC_ALG == NAIVE_TICTOC
+#if CC_ALG == NAIVE_TICTOC || CC_ALG == SILO
     case Message::LOCK_REQ:
         return process_lock_req(msg);
     case Message::LOCK_COMMIT:
@@ -472,7 +509,7 @@ TxnManager::process_remote_resp(Message * msg)
     return RCOK;
 }
 
-#if CC_ALG == NAIVE_TICTOC
+#if CC_ALG == NAIVE_TICTOC || CC_ALG == SILO
 RC
 TxnManager::process_lock_phase()
 {
@@ -484,8 +521,7 @@ TxnManager::process_lock_phase()
 
     _num_resp_expected = 0;
     bool resp_expected = false;
-    NaiveTicTocManager * tictoc_manager = (NaiveTicTocManager *) _cc_manager;
-    rc = tictoc_manager->process_lock_phase_coord();
+    rc = _cc_manager->process_lock_phase_coord();
     assert(rc == RCOK || rc == ABORT);
     if (rc == ABORT) {
         INC_INT_STATS(int_debug1, 1); // local abort in lock phase
@@ -521,8 +557,7 @@ TxnManager::process_lock_req(Message * msg)
     _txn_state = PREPARING;
     _resp_size = 0;
     _resp_data = NULL;
-    NaiveTicTocManager * tictoc_manager = (NaiveTicTocManager *) _cc_manager;
-    RC rc = tictoc_manager->process_lock_req(msg->get_data_size(), msg->get_data(), _resp_size, _resp_data);
+    RC rc = _cc_manager->process_lock_req(msg->get_data_size(), msg->get_data(), _resp_size, _resp_data);
     assert( rc == RCOK || rc == ABORT);
 
     Message::Type type;
@@ -541,8 +576,7 @@ TxnManager::process_lock_resp(Message * msg)
     RC rc = (msg->get_type() == Message::LOCK_ABORT)? ABORT : RCOK;
     // multiple threads may execute the following code concurrently, if multiple responses
     // are received.
-    NaiveTicTocManager * tictoc_manager = (NaiveTicTocManager *) _cc_manager;
-    tictoc_manager->process_lock_resp(rc, msg->get_src_node_id(), msg->get_data());
+    _cc_manager->process_lock_resp(rc, msg->get_src_node_id(), msg->get_data());
     if (rc == ABORT) {
         _txn_abort = true;
         _remote_txn_abort = true;
@@ -589,7 +623,7 @@ TxnManager::process_2pc_prepare_phase()
     rc = _cc_manager->process_prepare_phase_coord();
     if (rc == WAIT) {
         assert(CC_ALG != TICTOC || OCC_LOCK_TYPE == WAIT_DIE);
-        assert(CC_ALG != NAIVE_TICTOC);
+        assert(CC_ALG != NAIVE_TICTOC && CC_ALG != SILO);
         waiting_for_lock = true;
         _num_resp_expected = 1;
     }
@@ -646,8 +680,10 @@ TxnManager::process_2pc_prepare_req(Message * msg)
 #if CC_ALG == MAAT
     ((MaaTManager *)_cc_manager)->unlatch();
 #endif
+    // the system txn handles the prepare requests of txns it has not seen before.
+    _src_node_id = msg->get_src_node_id();
     _prepare_start_time = get_sys_clock();
-#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT
+#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == WOUND_WAIT || CC_ALG == DL_DETECT
     // TODO. right now, assume prepare is always successful.
     // send PREPARED right away
     RC rc = _cc_manager->process_prepare_req(msg->get_data_size(), msg->get_data(), _resp_size, _resp_data);
@@ -663,7 +699,8 @@ TxnManager::process_2pc_prepare_req(Message * msg)
     send_msg(resp_msg);
     return rc;
 #elif CC_ALG == TICTOC || CC_ALG == F_ONE || CC_ALG == MAAT  \
-    || CC_ALG == IDEAL_MVCC || CC_ALG == NAIVE_TICTOC || CC_ALG == TCM
+    || CC_ALG == IDEAL_MVCC || CC_ALG == NAIVE_TICTOC || CC_ALG == TCM \
+    || CC_ALG == SILO
     _resp_size = 0;
     _resp_data = NULL;
     RC rc = _cc_manager->process_prepare_req(msg->get_data_size(), msg->get_data(), _resp_size, _resp_data);
@@ -691,6 +728,10 @@ TxnManager::process_2pc_prepare_req(Message * msg)
     }
 #endif
     return rc;
+#elif CC_ALG == CALVIN
+    // CALVIN has no prepare phase.
+    assert(false);
+    return ABORT;
 #endif
 }
 
@@ -889,7 +930,10 @@ TxnManager::process_2pc_commit_req(Message * msg)
 #endif
 
     _cc_manager->process_commit_req(rc, msg->get_data_size(), msg->get_data());
+#if CC_ALG != CALVIN
+    // the coordinator of CALVIN does not wait for the participants.
     send_msg(new Message(Message::ACK, msg->get_src_node_id(), get_txn_id(), 0, NULL));
+#endif
     return rc;
 }
 
@@ -936,8 +980,7 @@ TxnManager::handle_local_caching()
     uint32_t size = _cc_manager->handle_local_caching(data);
     // Local caching resp does not target at a particular txn.
     // So the txn_id is 0, which is a wild card txn
-    Message * resp_msg;
-    NEW(resp_msg, Message, Message::LOCAL_COPY_RESP, _src_node_id, 0, size, data);
+    Message * resp_msg = new Message(Message::LOCAL_COPY_RESP, _src_node_id, 0, size, data);
     send_msg(resp_msg);
 #endif
 }
@@ -64,6 +64,8 @@ public:
 
     void set_sub_txn(bool is_sub_txn)     { _is_sub_txn = is_sub_txn; }
     bool is_sub_txn()                     { return _is_sub_txn; }
+    uint32_t get_src_node_id()            { return _src_node_id; }
+    ServerThread * get_server_thread()    { return _server_thread; }
     void set_msg(Message * msg)         { _msg = msg; }
 
     State             get_txn_state() { return _txn_state; }
@@ -117,7 +119,7 @@ private:
     // Commit phase for single-partition transactions.
     RC process_commit_phase_singlepart(RC rc);
 
-#if CC_ALG == NAIVE_TICTOC
+#if CC_ALG == NAIVE_TICTOC || CC_ALG == SILO
     // For naive TicToc or naive Silo, we need three phase commit.
     // The following lock phase is only for these two algorithms
     RC process_lock_phase();
@@ -145,7 +147,7 @@ private:
 
     // stats
     uint64_t        _txn_restart_time;     // after aborts
-    // only lock_phase exists only in NAIVE_TICTOC
+    // lock_phase only exists in NAIVE_TICTOC and SILO
     uint64_t         _lock_phase_start_time;
     uint64_t         _prepare_start_time;
     uint64_t         _cc_time;
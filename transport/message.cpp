@@ -1,52 +1,172 @@
 #include "message.h"
 #include "helper.h"
 #include "manager.h"
+#include "msg_pool.h"
 
 Message::Message(Type type, uint32_t dest, uint64_t txn_id, int size, char * data)
     : _msg_type(type)
     , _txn_id(txn_id)
     , _data_size(size)
     , _data(data)
+    , _pooled_data(false)
 {
     _dest_node_id = dest;
     _src_node_id = g_node_id;
+    _hlc = (g_ts_alloc == TS_HLC)? glob_manager->get_hlc() : 0;
 }
 
 Message::Message(Message * msg)
 {
     memcpy(this, msg, sizeof(Message));
-    _data = (char *) MALLOC(_data_size);
-    memcpy(_data, msg->get_data(), _data_size);
+    _pooled_data = true;
+    if (_data_size > 0) {
+        _data = (char *) MsgPool::alloc(_data_size);
+        memcpy(_data, msg->get_data(), _data_size);
+    } else
+        _data = NULL;
 }
 
 Message::Message(char * packet)
 {
-    memcpy(this, packet, sizeof(Message));
+    uint32_t pos = 0;
+    M_ASSERT((uint8_t)packet[pos] == MSG_WIRE_VERSION, "wire version %d\n", packet[pos]);
+    pos ++;
+    _msg_type = (Type)(uint8_t)packet[pos ++];
+    uint64_t value;
+    pos += decode_varint(packet + pos, value);
+    _src_node_id = value;
+    pos += decode_varint(packet + pos, value);
+    _txn_id = value;
+    pos += decode_varint(packet + pos, value);
+    _hlc = value;
+    if (_hlc > 0)
+        glob_manager->update_hlc(_hlc);
+    pos += decode_varint(packet + pos, value);
+    _data_size = value;
+    _dest_node_id = g_node_id;
+    _pooled_data = true;
     if (_data_size > 0) {
-        _data = (char *) MALLOC(_data_size);
-        memcpy(_data, packet + sizeof(Message), _data_size);
+        _data = (char *) MsgPool::alloc(_data_size);
+        memcpy(_data, packet + pos, _data_size);
     } else
         _data = NULL;
 }
 
 Message::~Message()
 {
-    if (_data_size > 0)
+    if (_data_size == 0)
+        return;
+    if (_pooled_data)
+        MsgPool::free(_data);
+    else
         FREE(_data, _data_size);
 }
 
+void *
+Message::operator new(size_t size)
+{
+    return MsgPool::alloc(size);
+}
+
+void
+Message::operator delete(void * ptr)
+{
+    MsgPool::free(ptr);
+}
+
+uint32_t
+Message::varint_size(uint64_t value)
+{
+    uint32_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size ++;
+    }
+    return size;
+}
+
+uint32_t
+Message::encode_varint(char * buf, uint64_t value)
+{
+    uint32_t size = 0;
+    while (value >= 0x80) {
+        buf[size ++] = (char)((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buf[size ++] = (char)value;
+    return size;
+}
+
+uint32_t
+Message::decode_varint(char * buf, uint64_t &value)
+{
+    uint32_t size = 0;
+    uint32_t shift = 0;
+    value = 0;
+    uint8_t byte;
+    do {
+        byte = (uint8_t)buf[size ++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return size;
+}
+
+uint32_t
+Message::get_header_len()
+{
+    return 2 + varint_size(_src_node_id) + varint_size(_txn_id) + varint_size(_hlc)
+        + varint_size(_data_size);
+}
+
 uint32_t
 Message::get_packet_len()
 {
-    return sizeof(Message) + _data_size;
+    return get_header_len() + _data_size;
+}
+
+uint32_t
+Message::to_header(char * header)
+{
+    uint32_t pos = 0;
+    header[pos ++] = (char)MSG_WIRE_VERSION;
+    header[pos ++] = (char)_msg_type;
+    pos += encode_varint(header + pos, _src_node_id);
+    pos += encode_varint(header + pos, _txn_id);
+    pos += encode_varint(header + pos, _hlc);
+    pos += encode_varint(header + pos, _data_size);
+    assert(pos <= MAX_MSG_HEADER_SIZE);
+    return pos;
 }
 
 void
 Message::to_packet(char * packet)
 {
-    memcpy(packet, this, sizeof(Message));
+    uint32_t header_len = to_header(packet);
     if (_data_size > 0)
-        memcpy(packet + sizeof(Message), _data, _data_size);
+        memcpy(packet + header_len, _data, _data_size);
+}
+
+uint32_t
+Message::peek_packet_len(char * packet, uint32_t size)
+{
+    // skip version and type
+    uint32_t pos = 2;
+    uint64_t data_size = 0;
+    // src_node_id, txn_id, hlc, data_size
+    for (uint32_t field = 0; field < 4; field ++) {
+        uint32_t shift = 0;
+        uint8_t byte;
+        data_size = 0;
+        do {
+            if (pos >= size)
+                return 0;
+            byte = (uint8_t)packet[pos ++];
+            data_size |= (uint64_t)(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+    }
+    return pos + data_size;
 }
 
 string
@@ -74,6 +194,9 @@ Message::get_name(Type type)
     case LOCAL_COPY_RESP:    return "LOCAL_COPY_RESP";
     case LOCAL_COPY_NACK:    return "LOCAL_COPY_NACK";
     case TCM_TS_SYNC_REQ:    return "TCM_TS_SYNC_REQ";
+    case WOUND_REQ:            return "WOUND_REQ";
+    case DL_EDGES:            return "DL_EDGES";
+    case CALVIN_BATCH:        return "CALVIN_BATCH";
     default:                assert(false);
     }
 }
@@ -2,6 +2,16 @@
 
 #include "global.h"
 
+// Wire format of a message. Only the fields below are sent; the destination is
+// implied by the socket. txn_id, hlc and data_size are varints (7 bits per byte).
+// hlc is the sender's clock for TS_HLC, and 0 otherwise.
+//
+//    | version (1B) | type (1B) | src_node_id (varint) | txn_id (varint) |
+//    | hlc (varint) | data_size (varint) | data (data_size bytes) |
+#define MSG_WIRE_VERSION    2
+// 1 + 1 + 5 + 10 + 10 + 5 bytes
+#define MAX_MSG_HEADER_SIZE 32
+
 class Message
 {
 public:
@@ -40,6 +50,12 @@ public:
 
         // For TCM
         TCM_TS_SYNC_REQ,
+        // For WOUND_WAIT. Asks the coordinator of a txn to abort it.
+        WOUND_REQ,
+        // For DL_DETECT. The waits-for edges of a node.
+        DL_EDGES,
+        // For CALVIN. A batch of new txns closed by the sequencer of a node.
+        CALVIN_BATCH,
         NUM_MSG_TYPES
     };
     Message(Type type, uint32_t dest, uint64_t txn_id, int size, char * data);
@@ -47,7 +63,13 @@ public:
     Message(char * packet);
     ~Message();
 
+    // Messages are allocated from the per-thread MsgPool.
+    static void * operator new(size_t size);
+    static void operator delete(void * ptr);
+
+    // number of bytes on the wire (header + data)
     uint32_t get_packet_len();
+    uint32_t get_header_len();
     uint32_t get_dest_id()         { return _dest_node_id; }
     void set_dest_id(uint32_t dest)    { _dest_node_id = dest; }
     uint32_t get_src_node_id()    { return _src_node_id; }
@@ -59,19 +81,33 @@ public:
     Type get_type()             { return _msg_type; }
     void set_type(Type type)     { _msg_type = type; }
     uint64_t get_txn_id()        { return _txn_id; }
+    uint64_t get_hlc()            { return _hlc; }
 
 
     void to_packet(char * packet);
+    // serialize the header only. returns the header length.
+    uint32_t to_header(char * header);
+    // returns the length of the packet starting at 'packet', or 0 if the first
+    // 'size' bytes do not contain a complete header.
+    static uint32_t peek_packet_len(char * packet, uint32_t size);
     static string get_name(Type type);
     static bool is_response(Type type);
     string get_name() { return get_name(get_type()); }
     bool is_response() { return is_response(get_type()); }
 private:
+    static uint32_t varint_size(uint64_t value);
+    static uint32_t encode_varint(char * buf, uint64_t value);
+    static uint32_t decode_varint(char * buf, uint64_t &value);
+
     Type         _msg_type;
     uint32_t     _src_node_id;
     uint32_t     _dest_node_id;
     uint64_t     _txn_id;
+    uint64_t     _hlc;
 
     uint32_t    _data_size;
     char *         _data;
+    // the payload was allocated from MsgPool by this message (received or copied).
+    // Otherwise, it was allocated by the sender with MALLOC or new.
+    bool        _pooled_data;
 };
@@ -0,0 +1,86 @@
+#include "msg_pool.h"
+#include "helper.h"
+
+static_assert(MSG_POOL_MIN_SIZE << (MSG_POOL_NUM_CLASSES - 1) == MAX_MESSAGE_SIZE,
+              "the largest size class should hold MAX_MESSAGE_SIZE");
+
+__thread MsgPool * MsgPool::_local_pool = NULL;
+
+MsgPool::MsgPool()
+{
+    for (uint32_t i = 0; i < MSG_POOL_NUM_CLASSES; i ++) {
+        _free_list[i] = NULL;
+        _return_stack[i] = NULL;
+    }
+}
+
+MsgPool *
+MsgPool::get_local_pool()
+{
+    // pools live as long as the process, since blocks may still be returned to them.
+    if (_local_pool == NULL) {
+        _local_pool = (MsgPool *) _mm_malloc(sizeof(MsgPool), 64);
+        new(_local_pool) MsgPool();
+    }
+    return _local_pool;
+}
+
+uint32_t
+MsgPool::get_size_class(uint32_t size)
+{
+    uint32_t size_class = 0;
+    uint32_t class_size = MSG_POOL_MIN_SIZE;
+    while (class_size < size && size_class < MSG_POOL_NUM_CLASSES) {
+        class_size <<= 1;
+        size_class ++;
+    }
+    return size_class;
+}
+
+void *
+MsgPool::alloc(uint32_t size)
+{
+    uint32_t size_class = get_size_class(size);
+    if (size_class == MSG_POOL_NUM_CLASSES) {
+        Block * block = (Block *) MALLOC(sizeof(Block) + size);
+        block->owner = NULL;
+        block->size_class = size_class;
+        return block + 1;
+    }
+    MsgPool * pool = get_local_pool();
+    FreeBlock * block = pool->_free_list[size_class];
+    if (block == NULL && pool->_return_stack[size_class] != NULL)
+        block = __sync_lock_test_and_set(&pool->_return_stack[size_class], NULL);
+    if (block == NULL) {
+        block = (FreeBlock *) MALLOC(sizeof(Block) + (MSG_POOL_MIN_SIZE << size_class));
+        block->header.owner = pool;
+        block->header.size_class = size_class;
+        block->next = NULL;
+    }
+    pool->_free_list[size_class] = block->next;
+    return &block->header + 1;
+}
+
+void
+MsgPool::free(void * ptr)
+{
+    if (ptr == NULL)
+        return;
+    FreeBlock * block = (FreeBlock *)((Block *)ptr - 1);
+    MsgPool * owner = block->header.owner;
+    uint32_t size_class = block->header.size_class;
+    if (owner == NULL) {
+        FREE(block, sizeof(Block));
+        return;
+    }
+    if (owner == _local_pool) {
+        block->next = owner->_free_list[size_class];
+        owner->_free_list[size_class] = block;
+        return;
+    }
+    FreeBlock * head;
+    do {
+        head = owner->_return_stack[size_class];
+        block->next = head;
+    } while (!ATOM_CAS(owner->_return_stack[size_class], head, block));
+}
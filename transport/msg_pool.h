@@ -0,0 +1,43 @@
+#pragma once
+
+#include "global.h"
+
+// Per-thread recycling pool for messages and their payloads.
+// Blocks are grouped in power-of-two size classes from MSG_POOL_MIN_SIZE to
+// MAX_MESSAGE_SIZE; larger blocks go to malloc. Each block remembers the pool
+// that allocated it.
+// - A block freed by its owner goes to the owner's free list.
+// - A block freed by another thread (e.g., a message created by a worker thread
+//   and deleted by an output thread) is pushed to the owner's return stack. The
+//   owner takes the whole stack back when its free list runs dry.
+// Blocks always go back to their owner, so each pool only holds as many blocks as
+// the thread had outstanding at its peak.
+#define MSG_POOL_MIN_SIZE        64
+#define MSG_POOL_NUM_CLASSES     9    // 64B ~ 16KB
+
+class MsgPool
+{
+public:
+    static void * alloc(uint32_t size);
+    static void free(void * ptr);
+private:
+    struct Block {
+        MsgPool *     owner;    // NULL if the block is from malloc
+        uint32_t      size_class;
+    } ALIGNED(16);
+    // a free block is linked through its payload.
+    struct FreeBlock {
+        Block         header;
+        FreeBlock *   next;
+    };
+
+    MsgPool();
+    static MsgPool * get_local_pool();
+    static uint32_t get_size_class(uint32_t size);
+
+    FreeBlock *          _free_list[MSG_POOL_NUM_CLASSES];
+    // pushed by other threads. popped as a whole by the owner.
+    FreeBlock * volatile _return_stack[MSG_POOL_NUM_CLASSES] ALIGNED(64);
+
+    static __thread MsgPool * _local_pool;
+};
@@ -0,0 +1,264 @@
+#include "shm_transport.h"
+#include "message.h"
+#include "global.h"
+#include "helper.h"
+#include <fcntl.h>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <time.h>
+
+#define SHM_READY_MAGIC 0x5348524e47524459UL
+// how long a receiver sleeps before it rechecks the rings.
+#define SHM_WAIT_TIMEOUT_NS 1000000
+
+static_assert((SHM_RING_SIZE & (SHM_RING_SIZE - 1)) == 0, "SHM_RING_SIZE must be a power of two");
+static_assert(SHM_RING_SIZE >= MAX_MESSAGE_SIZE, "SHM_RING_SIZE must hold a message");
+
+ShmTransport::ShmTransport(uint32_t transport_id)
+    : Transport(transport_id)
+{
+    if (g_num_nodes == 1)
+        return;
+    M_ASSERT(g_node_id < g_num_nodes, "[TRANSPORT_SHM] node id (-Dn) %d is not in ifconfig.txt\n", g_node_id);
+    _in_rings = new ShmRing * [g_num_nodes];
+    _out_rings = new ShmRing * [g_num_nodes];
+    _remote_bells = new ShmDoorbell * [g_num_nodes];
+
+    char name[128];
+    // create the objects this node receives from.
+    get_bell_name(name, g_node_id);
+    _bell = (ShmDoorbell *) create_shm(name, sizeof(ShmDoorbell));
+    for (uint32_t i = 0; i < g_num_nodes; i ++) {
+        _in_rings[i] = NULL;
+        if (i == g_node_id)
+            continue;
+        get_ring_name(name, i, g_node_id);
+        _in_rings[i] = (ShmRing *) create_shm(name, sizeof(ShmRing));
+        _in_rings[i]->ready = SHM_READY_MAGIC;
+    }
+    _bell->ready = SHM_READY_MAGIC;
+
+    // attach to the objects created by remote nodes.
+    for (uint32_t i = 0; i < g_num_nodes; i ++) {
+        _out_rings[i] = NULL;
+        _remote_bells[i] = NULL;
+        if (i == g_node_id)
+            continue;
+        get_ring_name(name, g_node_id, i);
+        _out_rings[i] = (ShmRing *) attach_shm(name, sizeof(ShmRing));
+        while (_out_rings[i]->ready != SHM_READY_MAGIC)
+            usleep(1000);
+        // both ends are mapped. The name is no longer needed.
+        shm_unlink(name);
+
+        get_bell_name(name, i);
+        _remote_bells[i] = (ShmDoorbell *) attach_shm(name, sizeof(ShmDoorbell));
+        while (_remote_bells[i]->ready != SHM_READY_MAGIC)
+            usleep(1000);
+    }
+    printf("[TRANSPORT_SHM] Transport %d of node %d attached to %d nodes\n",
+           transport_id, g_node_id, g_num_nodes - 1);
+}
+
+ShmTransport::~ShmTransport()
+{
+    if (g_num_nodes == 1)
+        return;
+    for (uint32_t i = 0; i < g_num_nodes; i ++) {
+        if (i == g_node_id)
+            continue;
+        munmap(_in_rings[i], sizeof(ShmRing));
+        munmap(_out_rings[i], sizeof(ShmRing));
+        munmap(_remote_bells[i], sizeof(ShmDoorbell));
+    }
+    munmap(_bell, sizeof(ShmDoorbell));
+    delete [] _in_rings;
+    delete [] _out_rings;
+    delete [] _remote_bells;
+}
+
+void
+ShmTransport::get_ring_name(char * name, uint32_t src, uint32_t dst)
+{
+    sprintf(name, "/sundial_ring_%d_%d_%d", _transport_id, src, dst);
+}
+
+void
+ShmTransport::get_bell_name(char * name, uint32_t node_id)
+{
+    sprintf(name, "/sundial_bell_%d_%d", _transport_id, node_id);
+}
+
+void *
+ShmTransport::create_shm(const char * name, size_t size)
+{
+    // remove the leftover of a previous run.
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    M_ASSERT(fd != -1, "shm_open(%s) failed: %s\n", name, strerror(errno));
+    int res = ftruncate(fd, size);
+    M_ASSERT(res == 0, "ftruncate(%s) failed: %s\n", name, strerror(errno));
+    void * addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    M_ASSERT(addr != MAP_FAILED, "mmap(%s) failed: %s\n", name, strerror(errno));
+    close(fd);
+    // ftruncate zero-fills the object.
+    return addr;
+}
+
+void *
+ShmTransport::attach_shm(const char * name, size_t size)
+{
+    int fd;
+    // the remote node may not have started yet.
+    while ((fd = shm_open(name, O_RDWR, 0600)) == -1)
+        usleep(1000);
+    // wait for the creator to size the object.
+    struct stat st;
+    do {
+        fstat(fd, &st);
+    } while ((size_t)st.st_size < size);
+    void * addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    M_ASSERT(addr != MAP_FAILED, "mmap(%s) failed: %s\n", name, strerror(errno));
+    close(fd);
+    return addr;
+}
+
+void
+ShmTransport::test_connect()
+{
+    Transport::test_connect();
+    // every remote node has attached to the doorbell by now.
+    char name[128];
+    get_bell_name(name, g_node_id);
+    shm_unlink(name);
+}
+
+uint32_t
+ShmTransport::send_iov(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort)
+{
+    ShmRing * ring = _out_rings[dest];
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < iovcnt; i++)
+        total += iov[i].iov_len;
+    uint64_t head = ring->head;
+    if (best_effort && SHM_RING_SIZE - (head - ring->tail) < total)
+        return 0;
+
+    // a batch may be larger than the ring. Publish the bytes as space frees up.
+    uint32_t idx = 0;
+    uint64_t offset = 0;
+    uint64_t bytes_sent = 0;
+    while (bytes_sent < total) {
+        uint64_t space;
+        while ((space = SHM_RING_SIZE - (head - ring->tail)) == 0)
+            PAUSE
+        uint64_t published = head + space;
+        while (idx < iovcnt && head < published) {
+            uint64_t len = min(iov[idx].iov_len - offset, published - head);
+            uint64_t pos = head & (SHM_RING_SIZE - 1);
+            uint64_t first = min(len, SHM_RING_SIZE - pos);
+            memcpy(ring->data + pos, (char *)iov[idx].iov_base + offset, first);
+            memcpy(ring->data, (char *)iov[idx].iov_base + offset + first, len - first);
+            head += len;
+            offset += len;
+            if (offset == iov[idx].iov_len) {
+                idx ++;
+                offset = 0;
+            }
+        }
+        bytes_sent += head - ring->head;
+        // x86 does not reorder stores, the data is visible before head.
+        COMPILER_BARRIER
+        ring->head = head;
+        wake_up(dest);
+    }
+    return bytes_sent;
+}
+
+void
+ShmTransport::wake_up(uint32_t dest)
+{
+    ShmDoorbell * bell = _remote_bells[dest];
+    // order the head update before reading sleeping. Pairs with the barrier in recvMsg().
+    __sync_synchronize();
+    if (bell->sleeping) {
+        __sync_fetch_and_add(&bell->seq, 1);
+        syscall(SYS_futex, &bell->seq, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+bool
+ShmTransport::pull_ring(uint32_t node_id)
+{
+    ShmRing * ring = _in_rings[node_id];
+    uint64_t tail = ring->tail;
+    uint64_t avail = ring->head - tail;
+    if (avail == 0)
+        return false;
+    // compact the recv buffer
+    uint32_t lower = _recv_buffer_lower[node_id];
+    uint32_t upper = _recv_buffer_upper[node_id];
+    if (lower > 0) {
+        memmove(_recv_buffer[node_id], _recv_buffer[node_id] + lower, upper - lower);
+        upper -= lower;
+        _recv_buffer_lower[node_id] = 0;
+        _recv_buffer_upper[node_id] = upper;
+    }
+    uint64_t len = min(avail, (uint64_t)(RECV_BUFFER_SIZE - upper));
+    if (len == 0)
+        return false;
+    uint64_t pos = tail & (SHM_RING_SIZE - 1);
+    uint64_t first = min(len, SHM_RING_SIZE - pos);
+    memcpy(_recv_buffer[node_id] + upper, ring->data + pos, first);
+    memcpy(_recv_buffer[node_id] + upper + first, ring->data, len - first);
+    _recv_buffer_upper[node_id] = upper + len;
+    // the bytes are copied out before the sender may reuse the space.
+    COMPILER_BARRIER
+    ring->tail = tail + len;
+    return true;
+}
+
+bool
+ShmTransport::has_pending_bytes()
+{
+    for (uint32_t i = 0; i < g_num_nodes; i ++)
+        if (i != g_node_id && _in_rings[i]->head != _in_rings[i]->tail)
+            return true;
+    return false;
+}
+
+Message *
+ShmTransport::recvMsg(bool wait)
+{
+    if (g_num_nodes == 1)
+        return NULL;
+    for (uint32_t i = 0; i < g_num_nodes; i ++) {
+        uint32_t node_id = (_rr_node_id ++) % g_num_nodes;
+        if (node_id == g_node_id)
+            continue;
+        Message * msg = parse_recv_buffer(node_id);
+        if (msg == NULL && pull_ring(node_id))
+            msg = parse_recv_buffer(node_id);
+        if (msg)
+            return msg;
+    }
+    if (g_recv_busy_poll || !wait)
+        return NULL;
+    // all rings are empty. Sleep until a sender rings the doorbell.
+    int32_t seq = _bell->seq;
+    _bell->sleeping = 1;
+    __sync_synchronize();
+    if (!has_pending_bytes()) {
+        struct timespec timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = SHM_WAIT_TIMEOUT_NS;
+        syscall(SYS_futex, &_bell->seq, FUTEX_WAIT, seq, &timeout, NULL, 0);
+    }
+    _bell->sleeping = 0;
+    return NULL;
+}
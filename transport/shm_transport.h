@@ -0,0 +1,52 @@
+#pragma once
+
+#include "transport.h"
+
+// [TRANSPORT_SHM] Transport for nodes running as processes on the same host.
+// Each (src, dst) pair of a transport has a single-producer single-consumer byte
+// ring in POSIX shared memory. The wire format is the same as TCP, so the
+// receive side reuses the packet parsing of Transport.
+// A receiver that finds all its rings empty sleeps on a futex in its doorbell;
+// senders only issue the wake-up syscall when the receiver is sleeping.
+// The shared memory objects are unlinked once every node has attached. After
+// a crash, stale objects are left in /dev/shm/sundial_*.
+class ShmTransport : public Transport
+{
+public:
+    ShmTransport(uint32_t transport_id);
+    ~ShmTransport();
+
+    Message * recvMsg(bool wait = true);
+    void test_connect();
+protected:
+    uint32_t send_iov(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort);
+private:
+    struct ShmRing {
+        // head and tail are monotonically increasing byte counters.
+        volatile uint64_t head __attribute__((aligned(64)));    // written by the sender
+        volatile uint64_t tail __attribute__((aligned(64)));    // written by the receiver
+        volatile uint64_t ready __attribute__((aligned(64)));
+        char data[SHM_RING_SIZE] __attribute__((aligned(64)));
+    };
+    struct ShmDoorbell {
+        volatile int32_t seq __attribute__((aligned(64)));
+        volatile int32_t sleeping __attribute__((aligned(64)));
+        volatile uint64_t ready;
+    };
+
+    void * create_shm(const char * name, size_t size);
+    void * attach_shm(const char * name, size_t size);
+    void get_ring_name(char * name, uint32_t src, uint32_t dst);
+    void get_bell_name(char * name, uint32_t node_id);
+
+    // copy the bytes in the ring into the recv buffer.
+    bool pull_ring(uint32_t node_id);
+    bool has_pending_bytes();
+    void wake_up(uint32_t dest);
+
+    // indexed by the remote node id.
+    ShmRing **          _in_rings;
+    ShmRing **          _out_rings;
+    ShmDoorbell **      _remote_bells;
+    ShmDoorbell *       _bell;
+};
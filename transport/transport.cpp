@@ -3,10 +3,14 @@
 #include "global.h"
 #include "helper.h"
 #include "manager.h"
+#include "shm_transport.h"
+#include "uring_transport.h"
+#include "msg_pool.h"
 #include <fcntl.h>
 #include <cstring>
 #include <errno.h>
 #include <netinet/tcp.h>
+#include <sys/epoll.h>
 //////////////////////////////////////////
 // Each node listens to port correpsonding to each remote node.
 // Each node pushes to the corresponing node's corresponding port
@@ -19,39 +23,75 @@
 #define PRINT_DEBUG_INFO false
 //#define PRINT_DEBUG_INFO true
 
-// The socket code is borrowed from
-// http://easy-tutorials.net/c/linux-c-socket-programming/
-// The external program execution code is borrowed from http://stackoverflow.com/questions/478898/how-to-execute-a-command-and-get-output-of-command-within-c-using-posix
+Transport *
+Transport::create(uint32_t transport_id)
+{
+    switch (g_transport_type) {
+    case TRANSPORT_TCP:
+        return new Transport(transport_id);
+    case TRANSPORT_SHM:
+        return new ShmTransport(transport_id);
+    case TRANSPORT_URING:
+        if (UringTransport::is_supported())
+            return new UringTransport(transport_id);
+        printf("[TRANSPORT_URING] io_uring is not available. Falling back to TRANSPORT_TCP\n");
+        return new Transport(transport_id);
+    default:
+        M_ASSERT(false, "Unsupported transport type %d\n", g_transport_type);
+        return NULL;
+    }
+}
+
+// Initialization shared by all the backends. TRANSPORT_SHM does not use sockets.
 Transport::Transport(uint32_t transport_id)
 {
     _transport_id = transport_id;
+    _net_emu_links = NULL;
+    _net_emu_active = false;
 
     read_urls();
     if (g_num_nodes == 1)
       return;
-    _local_info = new addrinfo [g_num_nodes];
-    _remote_info = new addrinfo [g_num_nodes];
-    _local_socks = new int [g_num_nodes];
-    _remote_socks = new int [g_num_nodes];
 
     _rr_node_id = 0;
     _recv_buffer = new char * [g_num_nodes];
     _recv_buffer_lower = new uint32_t [g_num_nodes];
     _recv_buffer_upper = new uint32_t [g_num_nodes];
-    _send_buffer = new char * [g_num_nodes];
-    //_send_buffer_size = new uint32_t [g_num_nodes];
-    _send_buffer_lower = new uint32_t [g_num_nodes];
-    _send_buffer_upper = new uint32_t [g_num_nodes];
+    _send_queue = new vector<Message *> [g_num_nodes];
+    _send_queue_bytes = new uint32_t [g_num_nodes];
+    _first_enqueue_time = new uint64_t [g_num_nodes];
+    _last_enqueue_time = new uint64_t [g_num_nodes];
+    _avg_enqueue_gap = new uint64_t [g_num_nodes];
+    _iov = new struct iovec [MAX_SEND_BATCH * 2];
+    _headers = new char [MAX_SEND_BATCH * MAX_MSG_HEADER_SIZE];
     for (uint32_t i = 0; i < g_num_nodes; i ++) {
         _recv_buffer[i] = new char [RECV_BUFFER_SIZE];
         //_recv_buffer_size[i] = 0;
         _recv_buffer_lower[i] = 0;
         _recv_buffer_upper[i] = 0;
 
-        _send_buffer[i] = new char [SEND_BUFFER_SIZE];
-        _send_buffer_lower[i] = 0;
-        _send_buffer_upper[i] = 0;
+        _send_queue_bytes[i] = 0;
+        _first_enqueue_time[i] = 0;
+        _last_enqueue_time[i] = 0;
+        _avg_enqueue_gap[i] = MSG_BUFFER_MAX_DELAY * 1000;
     }
+    _tot_bytes_sent = 0;
+    if (g_transport_type != TRANSPORT_SHM)
+        init_sockets();
+    // after init_sockets(), which sets g_node_id.
+    init_net_emu();
+}
+
+// The socket code is borrowed from
+// http://easy-tutorials.net/c/linux-c-socket-programming/
+// The external program execution code is borrowed from http://stackoverflow.com/questions/478898/how-to-execute-a-command-and-get-output-of-command-within-c-using-posix
+void
+Transport::init_sockets()
+{
+    _local_info = new addrinfo [g_num_nodes];
+    _remote_info = new addrinfo [g_num_nodes];
+    _local_socks = new int [g_num_nodes];
+    _remote_socks = new int [g_num_nodes];
 
     char hostname[1024];
     gethostname(hostname, 1023);
@@ -175,111 +215,351 @@ Transport::Transport(uint32_t transport_id)
         fcntl(new_sd, F_SETFL, O_NONBLOCK);
     }
 
+    // Register all incoming sockets with epoll (edge-triggered).
+    // The node id is stored in the event so no fd lookup is needed.
+    _sock_readable = new bool [g_num_nodes];
+    _node_ready = new bool [g_num_nodes];
+    _events = new epoll_event [g_num_nodes];
+    _epoll_fd = epoll_create1(0);
+    assert(_epoll_fd != -1);
+    for (uint32_t i = 0; i < g_num_nodes; i++) {
+        _sock_readable[i] = false;
+        _node_ready[i] = false;
+        if (i == global_node_id)
+            continue;
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.u32 = i;
+        int status = epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _local_socks[i], &ev);
+        assert(status != -1);
+        // data may have arrived before registration; the first round reads anyway.
+        _sock_readable[i] = true;
+        _node_ready[i] = true;
+        _ready_nodes.push(i);
+    }
+
     cout << "Socket initialized" << endl;
-    _tot_bytes_sent = 0;
 }
 
 uint32_t
 Transport::sendMsg(Message * msg)
 {
-#if !ENABLE_MSG_BUFFER
     uint32_t dest = msg->get_dest_id();
     M_ASSERT(dest < g_num_nodes, "dest=%d", dest);
-    uint32_t packet_size = msg->get_packet_len();
-    char data[packet_size];
-    msg->to_packet(data);
-    uint32_t bytes_sent = 0;
-    while (bytes_sent < packet_size) {
-        if (msg->get_type() == Message::DUMMY) {
-            int32_t size = send(_remote_socks[ dest ], data + bytes_sent, packet_size - bytes_sent, MSG_DONTWAIT);
-            if (size <= 0 && bytes_sent == 0)
-                break;
-            else if (size > 0)
-                bytes_sent += size;
-        } else {
-            int32_t size = send(_remote_socks[ dest ], data + bytes_sent, packet_size - bytes_sent, 0);
-            if (size > 0)
-                bytes_sent += size;
-        }
-    }
+    // keep the order with previously buffered messages.
+    if (!_send_queue[dest].empty())
+        flush_send_queue(dest);
+
+    // header and payload are sent from separate buffers.
+    char header[MAX_MSG_HEADER_SIZE];
+    struct iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len = msg->to_header(header);
+    iov[1].iov_base = msg->get_data();
+    iov[1].iov_len = msg->get_data_size();
+    uint32_t iovcnt = (msg->get_data_size() > 0)? 2 : 1;
+    uint32_t bytes_sent = transmit(dest, iov, iovcnt, msg->get_type() == Message::DUMMY);
 #if PRINT_DEBUG_INFO
     printf("\033[1;31m[TxnID=%5ld] Send %d->%d %16s [%4d bytes] fd=%d \033[0m\n",
            msg->get_txn_id(), GLOBAL_NODE_ID, dest, msg->get_name().c_str(), bytes_sent,
            _remote_socks[dest]);
 #endif
-
     return bytes_sent;
-#else
-    uint32_t dest = msg->get_dest_id();
-    assert(dest < g_num_nodes);
+}
 
-    // Right now use a very simple batching model:
-    //     Flush the buffer iff it is full, or it has not been flushed for 100 us.
-
-    // 1. if the upper is full, force sending until the buffer_size (upper - lower)
-    //    is small. Then shift the data in the buffer.
-    // 2. serialize msg to _send_buffer.
-    uint32_t len = msg->get_packet_len();
-    int32_t total_bytes = 0;
-    int32_t bytes_sent = 0;
-    // the upper is close to the end of buffer.
-    if (SEND_BUFFER_SIZE - _send_buffer_upper[dest] <= MAX_MESSAGE_SIZE) {
-        // the drain the buffer
-        while (_send_buffer_upper[dest] - _send_buffer_lower[dest] >= SEND_BUFFER_SIZE / 4) {
-            bytes_sent = send(_remote_socks[ dest ],
-                              _send_buffer[dest] + _send_buffer_lower[dest],
-                              _send_buffer_upper[dest] - _send_buffer_lower[dest], 0);
-            if (bytes_sent > 0) {
-                _send_buffer_lower[dest] += bytes_sent;
-                total_bytes += bytes_sent;
+uint32_t
+Transport::sendMsgBatch(uint32_t dest, Message ** msgs, uint32_t num_msgs)
+{
+    uint32_t total_bytes = 0;
+    for (uint32_t start = 0; start < num_msgs; start += MAX_SEND_BATCH) {
+        uint32_t batch = min(num_msgs - start, (uint32_t)MAX_SEND_BATCH);
+        uint32_t iovcnt = 0;
+        for (uint32_t i = 0; i < batch; i++) {
+            Message * msg = msgs[start + i];
+            assert(msg->get_dest_id() == dest);
+            char * header = _headers + i * MAX_MSG_HEADER_SIZE;
+            _iov[iovcnt].iov_base = header;
+            _iov[iovcnt].iov_len = msg->to_header(header);
+            iovcnt ++;
+            if (msg->get_data_size() > 0) {
+                _iov[iovcnt].iov_base = msg->get_data();
+                _iov[iovcnt].iov_len = msg->get_data_size();
+                iovcnt ++;
             }
         }
-        // shift the buffer.
-        if (_send_buffer_upper[dest] > _send_buffer_lower[dest])
-            memmove(_send_buffer[dest],
-                    _send_buffer[dest] + _send_buffer_lower[dest],
-                    _send_buffer_upper[dest] - _send_buffer_lower[dest]);
-        _send_buffer_upper[dest] -= _send_buffer_lower[dest];
-        _send_buffer_lower[dest] = 0;
+        total_bytes += transmit(dest, _iov, iovcnt, false);
     }
-    // serialize msg to the send buffer
-    assert(SEND_BUFFER_SIZE - _send_buffer_upper[dest] >= MAX_MESSAGE_SIZE);
-    msg->to_packet(_send_buffer[dest] + _send_buffer_upper[dest]);
-    _send_buffer_upper[dest] += len;
-
 #if PRINT_DEBUG_INFO
-    printf("\033[1;31m[TransID=%d] send %d->%d %s txnID=%ld, [%d bytes] fd=%d \033[0m\n",
-           _transport_id,
-           GLOBAL_NODE_ID, dest, msg->get_name().c_str(), msg->get_txn_id(), len,
-           _remote_socks[dest]);
-#endif
-    return total_bytes; //_send_buffer_upper[dest] - _send_buffer_lower;
+    printf("\033[1;31m[TransID=%d] send %d->%d batch of %d msgs [%d bytes] fd=%d \033[0m\n",
+           _transport_id, GLOBAL_NODE_ID, dest, num_msgs, total_bytes, _remote_socks[dest]);
 #endif
+    return total_bytes;
+}
+
+uint32_t
+Transport::bufferMsg(Message * msg)
+{
+    uint32_t dest = msg->get_dest_id();
+    assert(dest < g_num_nodes);
+    uint64_t now = get_sys_clock();
+    // moving average (1/8 weight) of the inter-arrival gap, capped so that one
+    // long idle period does not dominate.
+    uint64_t gap = min(now - _last_enqueue_time[dest], (uint64_t)MSG_BUFFER_MAX_DELAY * 1000);
+    _avg_enqueue_gap[dest] = (_avg_enqueue_gap[dest] * 7 + gap) / 8;
+    _last_enqueue_time[dest] = now;
+    if (_send_queue[dest].empty())
+        _first_enqueue_time[dest] = now;
+
+    _send_queue[dest].push_back(msg);
+    _send_queue_bytes[dest] += msg->get_packet_len();
+    if (_send_queue_bytes[dest] >= SEND_BUFFER_SIZE - MAX_MESSAGE_SIZE
+        || _send_queue[dest].size() >= MAX_SEND_BATCH
+        || is_send_queue_due(dest, now))
+    {
+        uint32_t bytes = _send_queue_bytes[dest];
+        flush_send_queue(dest);
+        return bytes;
+    }
+    return 0;
+}
+
+uint32_t
+Transport::sendDueMsg()
+{
+    uint32_t bytes = 0;
+    uint64_t now = get_sys_clock();
+    for (uint32_t dest = 0; dest < g_num_nodes; dest++) {
+        if (!_send_queue[dest].empty() && is_send_queue_due(dest, now)) {
+            bytes += _send_queue_bytes[dest];
+            flush_send_queue(dest);
+        }
+    }
+    return bytes;
+}
+
+bool
+Transport::is_send_queue_due(uint32_t dest, uint64_t now)
+{
+    uint64_t max_delay = MSG_BUFFER_MAX_DELAY * 1000;
+    uint64_t avg_gap = max(_avg_enqueue_gap[dest], (uint64_t)1);
+    if (now - _first_enqueue_time[dest] >= max_delay)
+        return true;
+    if (now - _last_enqueue_time[dest] >= 2 * avg_gap)
+        return true;
+    return _send_queue[dest].size() >= max_delay / avg_gap;
 }
 
 void
 Transport::sendBufferedMsg()
 {
-    //bool done = true;
+    for (uint32_t dest = 0; dest < g_num_nodes; dest++)
+        if (!_send_queue[dest].empty())
+            flush_send_queue(dest);
+    if (_net_emu_links == NULL)
+        return;
+    for (uint32_t dest = 0; dest < g_num_nodes; dest++)
+        while (!_delay_queue[dest].empty())
+            release_packet(dest, get_sys_clock());
+}
+
+void
+Transport::flush_send_queue(uint32_t dest)
+{
+    vector<Message *> &queue = _send_queue[dest];
+    sendMsgBatch(dest, queue.data(), queue.size());
+    INC_INT_STATS(num_msg_batches, 1);
+    for (uint32_t i = 0; i < queue.size(); i++)
+        delete queue[i];
+    queue.clear();
+    _send_queue_bytes[dest] = 0;
+}
+
+// Each line of net_emu_file is "src dst delay(us) jitter(us) bandwidth(Mbps)" and
+// overrides the default parameters (NET_EMU_*) of one link. Only the lines with
+// src == g_node_id apply to this node. Lines starting with '#' are ignored.
+void
+Transport::init_net_emu()
+{
+    bool enabled = false;
+    NetEmuLink * links = new NetEmuLink [g_num_nodes];
+    for (uint32_t i = 0; i < g_num_nodes; i ++) {
+        links[i].delay = g_net_emu_delay * 1000;
+        links[i].jitter = g_net_emu_jitter * 1000;
+        links[i].bandwidth = g_net_emu_bandwidth;
+        links[i].busy_until = 0;
+        links[i].last_release = 0;
+    }
+    if (g_net_emu_delay > 0 || g_net_emu_jitter > 0 || g_net_emu_bandwidth > 0)
+        enabled = true;
+    if (strlen(net_emu_file) > 0) {
+        ifstream file (net_emu_file);
+        M_ASSERT(file.is_open(), "cannot open %s\n", net_emu_file);
+        string line;
+        while (getline (file, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            uint32_t src, dst;
+            uint64_t delay, jitter, bandwidth;
+            int n = sscanf(line.c_str(), "%u %u %lu %lu %lu", &src, &dst, &delay, &jitter, &bandwidth);
+            M_ASSERT(n == 5 && dst < g_num_nodes, "invalid line in %s: %s\n", net_emu_file, line.c_str());
+            if (src != g_node_id)
+                continue;
+            links[dst].delay = delay * 1000;
+            links[dst].jitter = jitter * 1000;
+            links[dst].bandwidth = bandwidth;
+            if (delay > 0 || jitter > 0 || bandwidth > 0)
+                enabled = true;
+        }
+        file.close();
+    }
+    if (!enabled) {
+        delete [] links;
+        return;
+    }
+    _net_emu_links = links;
+    _delay_queue = new std::queue<DelayedPacket> [g_num_nodes];
+    if (_transport_id == 0) {
+        for (uint32_t i = 0; i < g_num_nodes; i ++) {
+            if (i == g_node_id) continue;
+            printf("[NET_EMU] link %d->%d: delay=%ldus jitter=%ldus bandwidth=%ldMbps\n",
+                   g_node_id, i, links[i].delay / 1000, links[i].jitter / 1000, links[i].bandwidth);
+        }
+    }
+}
+
+void
+Transport::startNetEmu()
+{
+    _net_emu_active = (_net_emu_links != NULL);
+}
+
+uint32_t
+Transport::transmit(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort)
+{
+    if (!_net_emu_active)
+        return send_iov(dest, iov, iovcnt, best_effort);
+    NetEmuLink &link = _net_emu_links[dest];
+    if (link.delay == 0 && link.jitter == 0 && link.bandwidth == 0)
+        return send_iov(dest, iov, iovcnt, best_effort);
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < iovcnt; i ++)
+        size += iov[i].iov_len;
+    delay_packet(dest, iov, iovcnt);
+    return size;
+}
+
+void
+Transport::delay_packet(uint32_t dest, struct iovec * iov, uint32_t iovcnt)
+{
+    NetEmuLink &link = _net_emu_links[dest];
+    DelayedPacket packet;
+    packet.size = 0;
+    for (uint32_t i = 0; i < iovcnt; i ++)
+        packet.size += iov[i].iov_len;
+    packet.data = (char *) MsgPool::alloc(packet.size);
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < iovcnt; i ++) {
+        memcpy(packet.data + offset, iov[i].iov_base, iov[i].iov_len);
+        offset += iov[i].iov_len;
+    }
+
+    uint64_t now = get_sys_clock();
+    // the packet leaves the emulated link after the queued bytes ahead of it.
+    // 1 Mbps is 1 bit per us.
+    uint64_t tx_time = (link.bandwidth > 0)? packet.size * 8 * 1000 / link.bandwidth : 0;
+    link.busy_until = max(link.busy_until, now) + tx_time;
+    int64_t delay = link.delay;
+    if (link.jitter > 0)
+        delay += (int64_t)((glob_manager->rand_double() * 2 - 1) * link.jitter);
+    // like TCP, a packet is not delivered before the ones sent earlier.
+    uint64_t release_time = link.busy_until + max(delay, (int64_t)0);
+    release_time = max(release_time, link.last_release);
+    link.last_release = release_time;
+
+    packet.enqueue_time = now;
+    packet.release_time = release_time;
+    _delay_queue[dest].push(packet);
+    INC_INT_STATS(num_net_emu_packets, 1);
+    INC_FLOAT_STATS(net_emu_delay, release_time - now);
+}
+
+void
+Transport::release_packet(uint32_t dest, uint64_t now)
+{
+    DelayedPacket &packet = _delay_queue[dest].front();
+    struct iovec iov;
+    iov.iov_base = packet.data;
+    iov.iov_len = packet.size;
+    send_iov(dest, &iov, 1, false);
+    // includes the time the output thread was busy past the release time.
+    INC_FLOAT_STATS(net_real_delay, now - packet.enqueue_time);
+    MsgPool::free(packet.data);
+    _delay_queue[dest].pop();
+}
+
+uint32_t
+Transport::sendDelayedMsg()
+{
+    if (_net_emu_links == NULL)
+        return 0;
+    uint32_t bytes = 0;
+    uint64_t now = get_sys_clock();
     for (uint32_t dest = 0; dest < g_num_nodes; dest++) {
-        while (_send_buffer_lower[dest] != _send_buffer_upper[dest]) {
-            int32_t bytes_sent = send(_remote_socks[ dest ],
-                                       _send_buffer[dest] + _send_buffer_lower[dest],
-                                       _send_buffer_upper[dest] - _send_buffer_lower[dest],
-                                       0);
-            if (bytes_sent > 0)
-                _send_buffer_lower[dest] += bytes_sent;
+        while (!_delay_queue[dest].empty() && _delay_queue[dest].front().release_time <= now) {
+            bytes += _delay_queue[dest].front().size;
+            release_packet(dest, now);
         }
-        _send_buffer_lower[dest] = 0;
-        _send_buffer_upper[dest] = 0;
     }
+    return bytes;
+}
+
+uint32_t
+Transport::send_iov(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort)
+{
+    uint32_t bytes_sent = 0;
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = iov;
+    hdr.msg_iovlen = iovcnt;
+    // TODO. right now, sending is blocking.
+    int flags = best_effort? MSG_DONTWAIT : 0;
+    while (hdr.msg_iovlen > 0) {
+        ssize_t size = sendmsg(_remote_socks[dest], &hdr, flags);
+        if (size <= 0) {
+            if (best_effort && bytes_sent == 0)
+                break;
+            continue;
+        }
+        bytes_sent += size;
+        // skip the iovecs that are completely sent. adjust a partially sent one.
+        while (hdr.msg_iovlen > 0 && (size_t)size >= hdr.msg_iov->iov_len) {
+            size -= hdr.msg_iov->iov_len;
+            hdr.msg_iov ++;
+            hdr.msg_iovlen --;
+        }
+        if (hdr.msg_iovlen > 0) {
+            hdr.msg_iov->iov_base = (char *)hdr.msg_iov->iov_base + size;
+            hdr.msg_iov->iov_len -= size;
+        }
+    }
+    return bytes_sent;
+}
+
+Message *
+Transport::recvMsg(bool wait)
+{
+    if (g_recv_busy_poll)
+        return recvMsgPoll();
+    else
+        return recvMsgEpoll(wait);
 }
 
+// Busy polling. Round robin over all the sockets with non-blocking recv().
+// Lowest latency, but an input thread occupies a full core even when idle.
 Message *
-Transport::recvMsg()
+Transport::recvMsgPoll()
 {
-    ssize_t bytes;
-    //char data[MAX_MESSAGE_SIZE];
     uint32_t global_node_id = g_node_id;
     for (uint32_t i = 0; i < g_num_nodes; i++) {
         uint32_t node_id = (i + _rr_node_id) % g_num_nodes;
@@ -297,46 +577,128 @@ Transport::recvMsg()
                 _recv_buffer_lower[node_id] = 0;
             }
             uint32_t max_size = RECV_BUFFER_SIZE - _recv_buffer_upper[node_id];
-//uint64_t tt = get_sys_clock();
-            bytes = recv(_local_socks[node_id],
-                             _recv_buffer[node_id] + _recv_buffer_upper[node_id],
-                          max_size, MSG_DONTWAIT);
-//if (stats)
-//INC_FLOAT_STATS(time_debug1, get_sys_clock() - tt);
+            ssize_t bytes = recv(_local_socks[node_id],
+                                 _recv_buffer[node_id] + _recv_buffer_upper[node_id],
+                                 max_size, MSG_DONTWAIT);
             if (bytes > 0)
                 _recv_buffer_upper[node_id] += bytes;
         }
 
-        if (_recv_buffer_upper[node_id] - _recv_buffer_lower[node_id] >= sizeof(Message)) {
-            Message * msg = (Message *) (_recv_buffer[node_id] + _recv_buffer_lower[node_id]);
-            assert(msg->get_packet_len() < MAX_MESSAGE_SIZE);
-            if (_recv_buffer_upper[node_id] - _recv_buffer_lower[node_id] >= msg->get_packet_len()) {
-                // Find a valid input message
-                msg = (Message *) MALLOC(sizeof(Message));
-                new(msg) Message(_recv_buffer[node_id] + _recv_buffer_lower[node_id]);
-                _recv_buffer_lower[node_id] += msg->get_packet_len();
-                if (_recv_buffer_upper[node_id] == _recv_buffer_lower[node_id]) {
-                    // a small optimization
-                    _recv_buffer_lower[node_id] = 0;
-                    _recv_buffer_upper[node_id] = 0;
-                }
-//INC_STATS(0, debug3, get_sys_clock() - t1);
-                //_recv_buffer_size[node_id] -= msg->get_packet_len();
-                _rr_node_id = (1 + _rr_node_id) % g_num_nodes;
-#if PRINT_DEBUG_INFO
-                printf("\033[1;32m[TxnID=%5ld] recv %d<-%d %16s [%4d bytes] fd=%d \033[0m\n",
-                       msg->get_txn_id(), global_node_id, msg->get_src_node_id(),
-                       msg->get_name().c_str(), msg->get_packet_len(),
-                       _local_socks[node_id]);
-#endif
-                return msg;
-            }
+        Message * msg = parse_recv_buffer(node_id);
+        if (msg) {
+            _rr_node_id = (1 + _rr_node_id) % g_num_nodes;
+            return msg;
         }
     }
     _rr_node_id = (1 + _rr_node_id) % g_num_nodes;
     return NULL;
 }
 
+// epoll based receiving. Only sockets that became readable are visited.
+// If nothing is ready, the thread sleeps in epoll_wait for at most 1 ms so that
+// the caller can still check for termination.
+Message *
+Transport::recvMsgEpoll(bool wait)
+{
+    Message * msg = recv_ready_nodes();
+    if (msg)
+        return msg;
+    int timeout = (wait && _ready_nodes.empty())? 1 : 0;
+    int num_events = epoll_wait(_epoll_fd, _events, g_num_nodes, timeout);
+    for (int i = 0; i < num_events; i++) {
+        uint32_t node_id = _events[i].data.u32;
+        _sock_readable[node_id] = true;
+        if (!_node_ready[node_id]) {
+            _node_ready[node_id] = true;
+            _ready_nodes.push(node_id);
+        }
+    }
+    if (num_events > 0)
+        return recv_ready_nodes();
+    return NULL;
+}
+
+// Ready nodes are visited round-robin, one message per visit. A node moves to the
+// back of _ready_nodes after each message, and its socket is only read when its
+// recv buffer has no complete message. It leaves the queue when both are drained.
+Message *
+Transport::recv_ready_nodes()
+{
+    uint32_t num_ready = _ready_nodes.size();
+    for (uint32_t i = 0; i < num_ready; i++) {
+        uint32_t node_id = _ready_nodes.front();
+        _ready_nodes.pop();
+        Message * msg = parse_recv_buffer(node_id);
+        if (!msg && _sock_readable[node_id]) {
+            fill_recv_buffer(node_id);
+            msg = parse_recv_buffer(node_id);
+        }
+        if (msg || _sock_readable[node_id])
+            _ready_nodes.push(node_id);
+        else
+            _node_ready[node_id] = false;
+        if (msg)
+            return msg;
+    }
+    return NULL;
+}
+
+void
+Transport::fill_recv_buffer(uint32_t node_id)
+{
+    // shift the remaining bytes to the beginning of the buffer.
+    if (_recv_buffer_lower[node_id] > 0) {
+        memmove(_recv_buffer[node_id],
+                _recv_buffer[node_id] + _recv_buffer_lower[node_id],
+                _recv_buffer_upper[node_id] - _recv_buffer_lower[node_id]);
+        _recv_buffer_upper[node_id] -= _recv_buffer_lower[node_id];
+        _recv_buffer_lower[node_id] = 0;
+    }
+    // With edge triggering, a socket must be drained until EAGAIN before the next
+    // notification. If the buffer fills up first, _sock_readable stays true.
+    while (_recv_buffer_upper[node_id] < RECV_BUFFER_SIZE) {
+        ssize_t bytes = recv(_local_socks[node_id],
+                             _recv_buffer[node_id] + _recv_buffer_upper[node_id],
+                             RECV_BUFFER_SIZE - _recv_buffer_upper[node_id], MSG_DONTWAIT);
+        if (bytes > 0)
+            _recv_buffer_upper[node_id] += bytes;
+        else if (bytes == -1 && errno == EINTR)
+            continue;
+        else {
+            // EAGAIN, or the remote node closed the connection.
+            _sock_readable[node_id] = false;
+            break;
+        }
+    }
+}
+
+Message *
+Transport::parse_recv_buffer(uint32_t node_id)
+{
+    uint32_t size = _recv_buffer_upper[node_id] - _recv_buffer_lower[node_id];
+    uint32_t packet_len = Message::peek_packet_len(_recv_buffer[node_id] + _recv_buffer_lower[node_id], size);
+    if (packet_len == 0)
+        return NULL;
+    assert(packet_len < MAX_MESSAGE_SIZE);
+    if (size < packet_len)
+        return NULL;
+    // Find a valid input message
+    Message * msg = new Message(_recv_buffer[node_id] + _recv_buffer_lower[node_id]);
+    _recv_buffer_lower[node_id] += msg->get_packet_len();
+    if (_recv_buffer_upper[node_id] == _recv_buffer_lower[node_id]) {
+        // a small optimization
+        _recv_buffer_lower[node_id] = 0;
+        _recv_buffer_upper[node_id] = 0;
+    }
+#if PRINT_DEBUG_INFO
+    printf("\033[1;32m[TxnID=%5ld] recv %d<-%d %16s [%4d bytes] fd=%d \033[0m\n",
+           msg->get_txn_id(), g_node_id, msg->get_src_node_id(),
+           msg->get_name().c_str(), msg->get_packet_len(),
+           _local_socks[node_id]);
+#endif
+    return msg;
+}
+
 void
 Transport::test_connect()
 {
@@ -345,14 +707,13 @@ Transport::test_connect()
     for (uint32_t i = 0; i < g_num_nodes; i++) {
         if (i == global_node_id)
             continue;
-        //Message * msg = new Message(Message::TERMINATE, i, 0, 0, NULL);
-        Message * msg;
-        NEW(msg, Message, Message::TERMINATE, i, 0, 0, NULL);
+        Message * msg = new Message(Message::TERMINATE, i, 0, 0, NULL);
         uint32_t bytes = sendMsg(msg);
         if (bytes != msg->get_packet_len())
             sendBufferedMsg();
         DELETE(Message, msg); //delete msg;
     }
+    pollSend();
     // receive msg from all nodes
     for (uint32_t i = 0; i < g_num_nodes - 1; i++) {
         Message * msg;
@@ -3,49 +3,150 @@
 #include "global.h"
 #include <sys/socket.h>
 #include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <queue>
 
 class Message;
 
+// max number of messages sent in a single sendmsg() call.
+#define MAX_SEND_BATCH 256
+
 // For now, each worker thread has its own Transport
 // The ith thread on one node only talks to ith thread on another node.
 class Transport
 {
 public:
+    // create the transport backend selected by g_transport_type.
+    static Transport * create(uint32_t transport_id);
+
     Transport(uint32_t transport_id);
+    virtual ~Transport() {};
+    // Send a message right away. Messages queued for the same destination are
+    // sent first. The caller keeps the ownership of msg.
     // returns the number of bytes sent.
     uint32_t sendMsg(Message * msg);
-    // retuens if all buffered messages are sent.
+    // Send multiple messages to the same destination in a single sendmsg() call.
+    // Headers and payloads are gathered with an iovec; payloads are not copied.
+    uint32_t sendMsgBatch(uint32_t dest, Message ** msgs, uint32_t num_msgs);
+    // [ENABLE_MSG_BUFFER] Queue a message. The transport takes the ownership of
+    // msg and deletes it after it is sent. Returns the number of bytes sent if
+    // the queue for the destination is flushed, otherwise 0.
+    uint32_t bufferMsg(Message * msg);
+    // [ENABLE_MSG_BUFFER] flush the destinations whose deadline has passed.
+    // returns the number of bytes sent.
+    uint32_t sendDueMsg();
+    // returns if all buffered messages are sent. This includes the packets held
+    // by network emulation, which are sent without waiting for their release time.
     void sendBufferedMsg();
-    Message * recvMsg();
+    // [NET_EMU] start holding outgoing bytes in the delay queues. Messages sent
+    // before (e.g., during the connection test) are not delayed.
+    void startNetEmu();
+    // [NET_EMU] send the packets whose release time has passed.
+    // returns the number of bytes sent.
+    uint32_t sendDelayedMsg();
+    // For asynchronous backends, submit the prepared sends and reap completions.
+    // Called by the output thread in every iteration.
+    virtual void pollSend() {};
+    // returns the next received message, or NULL. If wait is true and nothing has
+    // arrived, the input thread may sleep for a short while (unless g_recv_busy_poll).
+    virtual Message * recvMsg(bool wait = true);
 
     void terminate();
 
-    void test_connect();
+    virtual void test_connect();
+protected:
+    // return the next complete message in the recv buffer, or NULL.
+    Message * parse_recv_buffer(uint32_t node_id);
+    // send all the bytes described by iov. If best_effort is true, give up when the
+    // destination is not writable and nothing has been sent.
+    virtual uint32_t send_iov(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort);
+
+    // with multiple input/output threads, each pair uses a separate Transport.
+    uint32_t             _transport_id;
+
+    char **             _recv_buffer;
+    uint32_t *             _recv_buffer_lower;
+    uint32_t *             _recv_buffer_upper;
+
+    uint64_t             _rr_node_id;
+
+    int *                 _local_socks;
+    int    *                _remote_socks;
 private:
     void read_urls();
+    void init_sockets();
     uint32_t get_port_num(uint32_t node_id);
 
-    // with multiple input/output threads, each pair uses a separate Transport.
-    uint32_t             _transport_id;
+    // receive path
+    Message * recvMsgPoll();
+    Message * recvMsgEpoll(bool wait);
+    Message * recv_ready_nodes();
+    // read from the socket until it would block or the recv buffer is full.
+    void fill_recv_buffer(uint32_t node_id);
+
+    // send path
+    void flush_send_queue(uint32_t dest);
+    // send_iov(), or hold the bytes in the delay queue if network emulation is on.
+    uint32_t transmit(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort);
 
     vector<string> _urls;
     // For outputs, remote nodes information
     struct addrinfo *     _local_info;
     struct addrinfo *     _remote_info;
 
-    int *                 _local_socks;
-    int    *                _remote_socks;
-
-    char **             _recv_buffer;
-    //uint32_t *         _recv_buffer_size;
-    uint32_t *             _recv_buffer_lower;
-    uint32_t *             _recv_buffer_upper;
+    // [ENABLE_MSG_BUFFER] messages waiting to be sent to each node.
+    vector<Message *> *    _send_queue;
+    uint32_t *             _send_queue_bytes;
+    // Adaptive coalescing. Per destination, track the arrival time of the first
+    // and the last queued message, and a moving average of the inter-arrival gap.
+    // A queue is flushed when
+    //   1. the oldest message has waited MSG_BUFFER_MAX_DELAY, or
+    //   2. no message arrived for twice the average gap (the burst is over), or
+    //   3. the queue holds as many messages as would arrive within MSG_BUFFER_MAX_DELAY.
+    // Under low load (3) holds for the first message, so no delay is added.
+    bool is_send_queue_due(uint32_t dest, uint64_t now);
+    uint64_t *             _first_enqueue_time;
+    uint64_t *             _last_enqueue_time;
+    uint64_t *             _avg_enqueue_gap;
+    // scratch space for sendmsg()
+    struct iovec *         _iov;
+    char *                 _headers;
 
-    char **             _send_buffer;
-    uint32_t *             _send_buffer_lower;
-    uint32_t *             _send_buffer_upper;
+    // For epoll (edge-triggered) based receiving.
+    int                 _epoll_fd;
+    struct epoll_event * _events;
+    // the socket may still have unread data (no EAGAIN seen since the last edge).
+    bool *                 _sock_readable;
+    // the node is in _ready_nodes.
+    bool *                 _node_ready;
+    std::queue<uint32_t> _ready_nodes;
 
-    uint64_t             _rr_node_id;
+    // [NET_EMU] Network emulation. Each link to a remote node has a FIFO of
+    // timestamped packets. A packet is released after the link has serialized
+    // it at the emulated bandwidth plus the one-way delay and jitter. Release
+    // times never decrease, so the byte stream stays in order.
+    struct NetEmuLink {
+        uint64_t delay;         // in ns
+        uint64_t jitter;        // in ns
+        uint64_t bandwidth;     // in Mbps, 0 means unlimited
+        // the emulated link finishes serializing the queued bytes at this time.
+        uint64_t busy_until;
+        uint64_t last_release;
+    };
+    struct DelayedPacket {
+        uint64_t enqueue_time;
+        uint64_t release_time;
+        uint32_t size;
+        char *   data;
+    };
+    void init_net_emu();
+    void delay_packet(uint32_t dest, struct iovec * iov, uint32_t iovcnt);
+    void release_packet(uint32_t dest, uint64_t now);
+    // NULL if no link is emulated.
+    NetEmuLink *         _net_emu_links;
+    std::queue<DelayedPacket> * _delay_queue;
+    bool                 _net_emu_active;
     // Stats
     uint64_t             _tot_bytes_sent;
 };
@@ -0,0 +1,413 @@
+#include "uring_transport.h"
+#include "message.h"
+#include "global.h"
+#include "helper.h"
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#define URING_ENTRIES 256
+// registered receive buffers, shared by all the sockets of a transport.
+#define URING_RECV_BUFS 256
+#define URING_RECV_BUF_SIZE 4096
+#define URING_RECV_BGID 0
+// how long an idle input thread waits for a completion.
+#define URING_WAIT_TIMEOUT_NS 1000000
+
+// recvMsg() only copies a receive buffer when the node has no complete message
+// buffered, so less than MAX_MESSAGE_SIZE bytes are left in the recv buffer.
+static_assert(MAX_MESSAGE_SIZE + URING_RECV_BUF_SIZE <= RECV_BUFFER_SIZE,
+              "the recv buffer cannot hold a partial message and a receive buffer");
+
+bool
+UringTransport::is_supported()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, 2, &params);
+    if (fd < 0)
+        return false;
+    close(fd);
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG))
+        return false;
+
+    // The buffer ring (5.19) and multishot recv (6.0) cannot be told apart from the
+    // setup features, so a multishot recv of one byte is issued on a socketpair.
+    Uring ring;
+    uring_init(&ring, 2);
+    bool supported = false;
+    int socks[2];
+    struct io_uring_buf_ring * buf_ring = (struct io_uring_buf_ring *) mmap(NULL,
+        sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    char buf[16];
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)buf_ring;
+    reg.ring_entries = 1;
+    reg.bgid = URING_RECV_BGID;
+    if (buf_ring != MAP_FAILED
+        && syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0
+        && socketpair(AF_UNIX, SOCK_STREAM, 0, socks) == 0)
+    {
+        struct io_uring_buf * entry = (struct io_uring_buf *)buf_ring;
+        entry->addr = (uint64_t)buf;
+        entry->len = sizeof(buf);
+        entry->bid = 0;
+        __atomic_store_n(&buf_ring->tail, 1, __ATOMIC_RELEASE);
+        if (write(socks[1], "x", 1) == 1) {
+            struct io_uring_sqe * sqe = get_sqe(&ring);
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = socks[0];
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = URING_RECV_BGID;
+            uring_enter(&ring, true, URING_WAIT_TIMEOUT_NS);
+            struct io_uring_cqe * cqe = peek_cqe(&ring);
+            supported = (cqe != NULL && cqe->res == 1);
+        }
+        close(socks[0]);
+        close(socks[1]);
+    }
+    // tearing down the ring also cancels the recv and drops the buffer ring.
+    uring_exit(&ring);
+    if (buf_ring != MAP_FAILED)
+        munmap(buf_ring, sizeof(struct io_uring_buf));
+    return supported;
+}
+
+UringTransport::UringTransport(uint32_t transport_id)
+    : Transport(transport_id)
+{
+    if (g_num_nodes == 1)
+        return;
+    uring_init(&_send_ring, URING_ENTRIES);
+    uring_init(&_recv_ring, URING_ENTRIES);
+
+    _stage_buf = new char * [g_num_nodes];
+    _stage_len = new uint32_t [g_num_nodes];
+    _flight_buf = new char * [g_num_nodes];
+    _flight_len = new uint32_t [g_num_nodes];
+    _flight_offset = new uint32_t [g_num_nodes];
+    _in_flight = new bool [g_num_nodes];
+    for (uint32_t i = 0; i < g_num_nodes; i ++) {
+        _stage_buf[i] = new char [SEND_BUFFER_SIZE];
+        _flight_buf[i] = new char [SEND_BUFFER_SIZE];
+        _stage_len[i] = 0;
+        _flight_len[i] = 0;
+        _flight_offset[i] = 0;
+        _in_flight[i] = false;
+    }
+
+    // register the buffer ring for multishot receives.
+    _buf_ring = (struct io_uring_buf_ring *) mmap(NULL, URING_RECV_BUFS * sizeof(struct io_uring_buf),
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(_buf_ring != MAP_FAILED);
+    _buf_pool = new char [URING_RECV_BUFS * URING_RECV_BUF_SIZE];
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)_buf_ring;
+    reg.ring_entries = URING_RECV_BUFS;
+    reg.bgid = URING_RECV_BGID;
+    int res = syscall(__NR_io_uring_register, _recv_ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1);
+    M_ASSERT(res == 0, "[TRANSPORT_URING] failed to register the buffer ring: %s\n", strerror(errno));
+    _buf_ring_tail = 0;
+    for (uint32_t i = 0; i < URING_RECV_BUFS; i ++)
+        return_recv_buf(i);
+
+    for (uint32_t i = 0; i < g_num_nodes; i ++)
+        if (i != g_node_id)
+            arm_recv(i);
+    uring_enter(&_recv_ring, false, 0);
+    printf("[TRANSPORT_URING] Transport %d initialized\n", transport_id);
+}
+
+//////////////////////////////////////////
+// io_uring
+//////////////////////////////////////////
+void
+UringTransport::uring_init(Uring * ring, uint32_t entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    M_ASSERT(ring->fd >= 0, "[TRANSPORT_URING] io_uring_setup failed: %s\n", strerror(errno));
+    M_ASSERT(params.features & IORING_FEAT_SINGLE_MMAP, "[TRANSPORT_URING] kernel too old\n");
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t size = max(sq_size, cq_size);
+    char * ptr = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               ring->fd, IORING_OFF_SQ_RING);
+    assert(ptr != MAP_FAILED);
+    ring->sqes = (struct io_uring_sqe *) mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    assert(ring->sqes != MAP_FAILED);
+
+    ring->sq_entries = params.sq_entries;
+    ring->sq_head = (uint32_t *)(ptr + params.sq_off.head);
+    ring->sq_tail = (uint32_t *)(ptr + params.sq_off.tail);
+    ring->sq_mask = (uint32_t *)(ptr + params.sq_off.ring_mask);
+    // SQE i always sits in slot i.
+    uint32_t * sq_array = (uint32_t *)(ptr + params.sq_off.array);
+    for (uint32_t i = 0; i < params.sq_entries; i ++)
+        sq_array[i] = i;
+    ring->cq_head = (uint32_t *)(ptr + params.cq_off.head);
+    ring->cq_tail = (uint32_t *)(ptr + params.cq_off.tail);
+    ring->cq_mask = (uint32_t *)(ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(ptr + params.cq_off.cqes);
+    ring->to_submit = 0;
+    ring->ring_mem = ptr;
+    ring->ring_size = size;
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+}
+
+void
+UringTransport::uring_exit(Uring * ring)
+{
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->ring_mem, ring->ring_size);
+    close(ring->fd);
+}
+
+struct io_uring_sqe *
+UringTransport::get_sqe(Uring * ring)
+{
+    uint32_t tail = *ring->sq_tail;
+    if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) == ring->sq_entries) {
+        uring_enter(ring, false, 0);
+        assert(tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) < ring->sq_entries);
+    }
+    struct io_uring_sqe * sqe = &ring->sqes[tail & *ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    // the caller fills the SQE before the kernel sees it in uring_enter().
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit ++;
+    return sqe;
+}
+
+void
+UringTransport::uring_enter(Uring * ring, bool wait, uint64_t timeout_ns)
+{
+    if (ring->to_submit == 0 && !wait)
+        return;
+    uint32_t flags = 0;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    if (wait) {
+        memset(&arg, 0, sizeof(arg));
+        ts.tv_sec = timeout_ns / BILLION;
+        ts.tv_nsec = timeout_ns % BILLION;
+        arg.ts = (uint64_t)&ts;
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    }
+    int res;
+    do {
+        res = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, wait? 1 : 0, flags,
+                      wait? &arg : NULL, sizeof(arg));
+    } while (res < 0 && errno == EINTR);
+    M_ASSERT(res >= 0 || errno == ETIME || errno == EBUSY,
+             "[TRANSPORT_URING] io_uring_enter failed: %s\n", strerror(errno));
+    if (res > 0)
+        ring->to_submit -= min((uint32_t)res, ring->to_submit);
+}
+
+struct io_uring_cqe *
+UringTransport::peek_cqe(Uring * ring)
+{
+    uint32_t head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+void
+UringTransport::cqe_seen(Uring * ring)
+{
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+//////////////////////////////////////////
+// Send
+//////////////////////////////////////////
+uint32_t
+UringTransport::send_iov(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort)
+{
+    reap_send();
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iovcnt; i++)
+        total += iov[i].iov_len;
+    if (best_effort && SEND_BUFFER_SIZE - _stage_len[dest] < total)
+        return 0;
+
+    for (uint32_t i = 0; i < iovcnt; i++) {
+        char * data = (char *) iov[i].iov_base;
+        uint32_t len = iov[i].iov_len;
+        while (len > 0) {
+            if (_stage_len[dest] == SEND_BUFFER_SIZE) {
+                // wait until the staging buffer can be handed to the kernel.
+                while (_in_flight[dest]) {
+                    uring_enter(&_send_ring, true, URING_WAIT_TIMEOUT_NS);
+                    reap_send();
+                }
+                start_send(dest);
+            }
+            uint32_t size = min(len, SEND_BUFFER_SIZE - _stage_len[dest]);
+            memcpy(_stage_buf[dest] + _stage_len[dest], data, size);
+            _stage_len[dest] += size;
+            data += size;
+            len -= size;
+        }
+    }
+    if (!_in_flight[dest])
+        start_send(dest);
+    return total;
+}
+
+void
+UringTransport::pollSend()
+{
+    if (g_num_nodes == 1)
+        return;
+    reap_send();
+    uring_enter(&_send_ring, false, 0);
+}
+
+void
+UringTransport::start_send(uint32_t dest)
+{
+    assert(!_in_flight[dest] && _stage_len[dest] > 0);
+    char * buf = _flight_buf[dest];
+    _flight_buf[dest] = _stage_buf[dest];
+    _flight_len[dest] = _stage_len[dest];
+    _flight_offset[dest] = 0;
+    _stage_buf[dest] = buf;
+    _stage_len[dest] = 0;
+    _in_flight[dest] = true;
+    prep_send(dest);
+}
+
+void
+UringTransport::prep_send(uint32_t dest)
+{
+    struct io_uring_sqe * sqe = get_sqe(&_send_ring);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = _remote_socks[dest];
+    sqe->addr = (uint64_t)(_flight_buf[dest] + _flight_offset[dest]);
+    sqe->len = _flight_len[dest] - _flight_offset[dest];
+    sqe->user_data = dest;
+}
+
+void
+UringTransport::reap_send()
+{
+    struct io_uring_cqe * cqe;
+    while ((cqe = peek_cqe(&_send_ring)) != NULL) {
+        uint32_t dest = cqe->user_data;
+        int32_t res = cqe->res;
+        cqe_seen(&_send_ring);
+        if (res == -EAGAIN || res == -EINTR)
+            res = 0;
+        M_ASSERT(res >= 0, "[TRANSPORT_URING] send to node %d failed: %s\n", dest, strerror(-res));
+        assert(_in_flight[dest]);
+        _flight_offset[dest] += res;
+        if (_flight_offset[dest] < _flight_len[dest]) {
+            // short send. Send the rest before anything else.
+            prep_send(dest);
+            continue;
+        }
+        _in_flight[dest] = false;
+        if (_stage_len[dest] > 0)
+            start_send(dest);
+    }
+}
+
+//////////////////////////////////////////
+// Receive
+//////////////////////////////////////////
+void
+UringTransport::arm_recv(uint32_t node_id)
+{
+    struct io_uring_sqe * sqe = get_sqe(&_recv_ring);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = _local_socks[node_id];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_RECV_BGID;
+    sqe->user_data = node_id;
+}
+
+void
+UringTransport::return_recv_buf(uint16_t bid)
+{
+    // in C++, __DECLARE_FLEX_ARRAY puts bufs after an empty struct, which is not
+    // where the kernel expects it. Index the ring memory directly.
+    struct io_uring_buf * buf = (struct io_uring_buf *)_buf_ring + (_buf_ring_tail & (URING_RECV_BUFS - 1));
+    buf->addr = (uint64_t)(_buf_pool + (uint64_t)bid * URING_RECV_BUF_SIZE);
+    buf->len = URING_RECV_BUF_SIZE;
+    buf->bid = bid;
+    _buf_ring_tail ++;
+    __atomic_store_n(&_buf_ring->tail, _buf_ring_tail, __ATOMIC_RELEASE);
+}
+
+Message *
+UringTransport::recvMsg(bool wait)
+{
+    if (g_num_nodes == 1)
+        return NULL;
+    for (uint32_t i = 0; i < g_num_nodes; i ++) {
+        uint32_t node_id = (_rr_node_id ++) % g_num_nodes;
+        if (node_id == g_node_id)
+            continue;
+        Message * msg = parse_recv_buffer(node_id);
+        if (msg)
+            return msg;
+    }
+    // no complete message is buffered. Consume completions until one is.
+    bool waited = g_recv_busy_poll || !wait;
+    while (true) {
+        struct io_uring_cqe * cqe = peek_cqe(&_recv_ring);
+        if (cqe == NULL) {
+            if (waited) {
+                uring_enter(&_recv_ring, false, 0);
+                return NULL;
+            }
+            uring_enter(&_recv_ring, true, URING_WAIT_TIMEOUT_NS);
+            waited = true;
+            continue;
+        }
+        uint32_t node_id = cqe->user_data;
+        int32_t res = cqe->res;
+        uint32_t flags = cqe->flags;
+        cqe_seen(&_recv_ring);
+        if (res > 0) {
+            uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+            uint32_t lower = _recv_buffer_lower[node_id];
+            uint32_t upper = _recv_buffer_upper[node_id];
+            if (lower > 0) {
+                memmove(_recv_buffer[node_id], _recv_buffer[node_id] + lower, upper - lower);
+                upper -= lower;
+                _recv_buffer_lower[node_id] = 0;
+            }
+            assert(upper + res <= RECV_BUFFER_SIZE);
+            memcpy(_recv_buffer[node_id] + upper, _buf_pool + (uint64_t)bid * URING_RECV_BUF_SIZE, res);
+            _recv_buffer_upper[node_id] = upper + res;
+            return_recv_buf(bid);
+        } else if (res == 0) {
+            // the remote node closed the connection.
+            continue;
+        } else
+            M_ASSERT(res == -ENOBUFS || res == -EAGAIN || res == -EINTR,
+                     "[TRANSPORT_URING] recv from node %d failed: %s\n", node_id, strerror(-res));
+        // the multishot recv stops when it runs out of buffers.
+        if (!(flags & IORING_CQE_F_MORE))
+            arm_recv(node_id);
+        Message * msg = parse_recv_buffer(node_id);
+        if (msg) {
+            uring_enter(&_recv_ring, false, 0);
+            return msg;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "transport.h"
+#include <linux/io_uring.h>
+
+// [TRANSPORT_URING] TCP transport driven by io_uring. It uses the same sockets as
+// Transport.
+// Send: send_iov() copies the bytes into a per-destination staging buffer and
+//   returns without a syscall. Each destination has at most one send in flight,
+//   which keeps the byte stream in order. Bytes that arrive while a send is in
+//   flight go out together in the next send. pollSend() submits all prepared sends
+//   in one io_uring_enter() and reaps completions from the shared CQ ring.
+// Receive: every socket has a multishot recv that picks buffers from a registered
+//   buffer ring, so no syscall is needed while completions are pending.
+class UringTransport : public Transport
+{
+public:
+    UringTransport(uint32_t transport_id);
+
+    // io_uring may be compiled out or disabled (kernel.io_uring_disabled), or lack
+    // the buffer ring and multishot recv that the receive path needs.
+    static bool is_supported();
+
+    Message * recvMsg(bool wait = true);
+    void pollSend();
+protected:
+    uint32_t send_iov(uint32_t dest, struct iovec * iov, uint32_t iovcnt, bool best_effort);
+private:
+    // a minimal io_uring (no liburing).
+    struct Uring {
+        int                     fd;
+        uint32_t                sq_entries;
+        uint32_t *              sq_head;
+        uint32_t *              sq_tail;
+        uint32_t *              sq_mask;
+        struct io_uring_sqe *   sqes;
+        uint32_t *              cq_head;
+        uint32_t *              cq_tail;
+        uint32_t *              cq_mask;
+        struct io_uring_cqe *   cqes;
+        // SQEs published but not yet submitted to the kernel.
+        uint32_t                to_submit;
+        // the mapped ring memory, for uring_exit().
+        char *                  ring_mem;
+        size_t                  ring_size;
+        size_t                  sqes_size;
+    };
+    static void uring_init(Uring * ring, uint32_t entries);
+    static void uring_exit(Uring * ring);
+    static struct io_uring_sqe * get_sqe(Uring * ring);
+    // submit pending SQEs. If wait is true, wait up to timeout_ns for a completion.
+    static void uring_enter(Uring * ring, bool wait, uint64_t timeout_ns);
+    static struct io_uring_cqe * peek_cqe(Uring * ring);
+    static void cqe_seen(Uring * ring);
+
+    // send path
+    void start_send(uint32_t dest);
+    void prep_send(uint32_t dest);
+    void reap_send();
+    Uring               _send_ring;
+    // bytes waiting for the next send, and bytes owned by the kernel.
+    char **             _stage_buf;
+    uint32_t *          _stage_len;
+    char **             _flight_buf;
+    uint32_t *          _flight_len;
+    uint32_t *          _flight_offset;
+    bool *              _in_flight;
+
+    // receive path
+    void arm_recv(uint32_t node_id);
+    void return_recv_buf(uint16_t bid);
+    Uring               _recv_ring;
+    struct io_uring_buf_ring * _buf_ring;
+    char *              _buf_pool;
+    uint16_t            _buf_ring_tail;
+};
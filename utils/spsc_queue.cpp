@@ -0,0 +1,66 @@
+#include "spsc_queue.h"
+#include "helper.h"
+
+SpscQueue::SpscQueue(uint32_t capacity)
+{
+    uint64_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    _buffer = (uint64_t *) _mm_malloc(sizeof(uint64_t) * size, 64);
+    _mask = size - 1;
+    _head = 0;
+    _cached_tail = 0;
+    _tail = 0;
+    _cached_head = 0;
+}
+
+SpscQueue::~SpscQueue()
+{
+    _mm_free(_buffer);
+}
+
+bool
+SpscQueue::push(uint64_t value)
+{
+    return push_batch(&value, 1) == 1;
+}
+
+uint32_t
+SpscQueue::push_batch(uint64_t * values, uint32_t num_values)
+{
+    uint64_t head = _head;
+    uint64_t free_slots = _mask + 1 - (head - _cached_tail);
+    if (free_slots < num_values) {
+        _cached_tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        free_slots = _mask + 1 - (head - _cached_tail);
+    }
+    uint32_t n = (free_slots < num_values)? free_slots : num_values;
+    for (uint32_t i = 0; i < n; i ++)
+        _buffer[(head + i) & _mask] = values[i];
+    // publish the values to the consumer.
+    __atomic_store_n(&_head, head + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+bool
+SpscQueue::pop(uint64_t &value)
+{
+    return pop_batch(&value, 1) == 1;
+}
+
+uint32_t
+SpscQueue::pop_batch(uint64_t * values, uint32_t max_values)
+{
+    uint64_t tail = _tail;
+    uint64_t available = _cached_head - tail;
+    if (available < max_values) {
+        _cached_head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        available = _cached_head - tail;
+    }
+    uint32_t n = (available < max_values)? available : max_values;
+    for (uint32_t i = 0; i < n; i ++)
+        values[i] = _buffer[(tail + i) & _mask];
+    // release the slots to the producer.
+    __atomic_store_n(&_tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+// Bounded single-producer single-consumer ring of 64-bit values.
+// The capacity is set at runtime and rounded up to a power of two.
+// The producer and the consumer each own a cache line with their index and a
+// cached copy of the other side's index. The other side's line is only read
+// when the cached copy says the ring is full (or empty).
+class SpscQueue
+{
+public:
+    SpscQueue(uint32_t capacity);
+    ~SpscQueue();
+
+    // producer
+    bool push(uint64_t value);
+    // returns the number of values pushed, in order.
+    uint32_t push_batch(uint64_t * values, uint32_t num_values);
+
+    // consumer
+    bool pop(uint64_t &value);
+    template<typename T>
+    bool pop(T * &value) {
+        uint64_t v;
+        if (!pop(v))
+            return false;
+        value = (T *) v;
+        return true;
+    }
+    // returns the number of values popped, at most max_values.
+    uint32_t pop_batch(uint64_t * values, uint32_t max_values);
+private:
+    // written by the producer
+    uint64_t             _head __attribute__((aligned(64)));
+    uint64_t             _cached_tail;
+    // written by the consumer
+    uint64_t             _tail __attribute__((aligned(64)));
+    uint64_t             _cached_head;
+    // read-only
+    uint64_t *           _buffer __attribute__((aligned(64)));
+    uint64_t             _mask;
+};